@@ -1,3 +1,7 @@
+#if defined(__linux__) && !defined(_GNU_SOURCE)
+#define _GNU_SOURCE // For fallocate()
+#endif
+
 #include <assert.h>
 #include <bare.h>
 #include <js.h>
@@ -12,25 +16,219 @@
 #include <unistd.h>
 #endif
 
+#ifdef _WIN32
+#include <malloc.h>
+#else
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef __linux__
+#include <linux/falloc.h>
+#include <stdio.h>
+#endif
+
+#ifdef __APPLE__
+#include <sys/param.h>
+#endif
+
+#include "glob.h"
+#include "hash.h"
+
 typedef struct {
   uv_fs_t handle;
 
+  // Used in place of `handle` for operations that libuv does not provide,
+  // which instead run as work on the threadpool and report their result
+  // through `handle.result`.
+  uv_work_t work;
+  void *job;
+
   js_env_t *env;
   js_ref_t *ctx;
   js_ref_t *on_result;
 
   bool exiting;
   bool inflight;
+  bool working;
+
+  // Whether failures are reported as negative statuses rather than errors,
+  // for probes that expect to fail often.
+  bool probe;
 
   js_deferred_teardown_t *teardown;
 } bare_fs_req_t;
 
 typedef utf8_t bare_fs_path_t[4096 + 1 /* NULL */];
 
+typedef struct {
+  uv_file fd;
+  bare_fs_path_t path;
+
+  int64_t offset;
+  int64_t length;
+
+  bare_fs_hash_t hash;
+
+  size_t digest_len;
+  uint8_t digest[BARE_FS_HASH_MAX_DIGEST_LEN];
+} bare_fs_hash_file_t;
+
+enum {
+  bare_fs_fallocate_keep_size = 1,
+  bare_fs_fallocate_punch_hole = 2,
+  bare_fs_fallocate_zero_range = 4,
+  bare_fs_fallocate_collapse_range = 8,
+};
+
+enum {
+  bare_fs_writeback_wait = 1,
+  bare_fs_writeback_drop = 2,
+};
+
+// Job for operations on a range of a file, such as fallocate and writeback.
+typedef struct {
+  uv_file fd;
+  int mode;
+
+  int64_t offset;
+  int64_t length;
+} bare_fs_file_range_t;
+
+typedef struct {
+  uv_file fd;
+  int64_t offset;
+
+  double *ranges;
+  uint32_t len;
+} bare_fs_data_ranges_t;
+
+typedef struct {
+  bare_fs_path_t src;
+  bare_fs_path_t dst;
+  int32_t mode;
+} bare_fs_copyfile_sparse_t;
+
+typedef struct {
+  uint64_t dev;
+  uint64_t ino;
+  bool used;
+} bare_fs_disk_usage_inode_t;
+
+// Set of the inodes with several hard links seen by a disk usage computation,
+// shared between the jobs of the computation.
+typedef struct {
+  uv_mutex_t lock;
+
+  bare_fs_disk_usage_inode_t *inodes;
+  size_t len;
+  size_t capacity;
+} bare_fs_disk_usage_links_t;
+
+typedef struct {
+  bare_fs_path_t path;
+  bool apparent;
+  int32_t max_depth;
+
+  // Whether the root itself is counted, or only its entries.
+  bool self;
+
+  bare_fs_disk_usage_links_t *links;
+
+  // Total bytes, blocks, and inodes.
+  double *result;
+} bare_fs_disk_usage_t;
+
+// Number of fields per file in the results of a stat sweep, in the order of
+// `bare_fs_request_result_stat()`.
+#define BARE_FS_STAT_FIELDS 14
+
+typedef struct {
+  // NULL-terminated paths, one after the other.
+  const utf8_t *paths;
+  uint32_t len;
+
+  const double *prev;
+  double *next;
+
+  // Indices of the files whose stats changed since the previous sweep.
+  uint32_t *changed;
+} bare_fs_stat_sweep_t;
+
+typedef struct {
+  uv_file fd;
+  int64_t pos;
+
+  uint8_t *data;
+  size_t len;
+  size_t capacity;
+
+  uint32_t *lines;
+  uint32_t lines_len;
+} bare_fs_read_lines_t;
+
+// Job for reading the rest of a file into native memory, to be decoded into a
+// string without an intermediate buffer.
+typedef struct {
+  uv_file fd;
+
+  char *data;
+  size_t len;
+  size_t size;
+} bare_fs_read_utf8_t;
+
+// Job for writing a string encoded into native memory, without an
+// intermediate buffer.
+typedef struct {
+  uv_file fd;
+  int64_t pos;
+
+  char *data;
+  size_t len;
+} bare_fs_write_utf8_t;
+
+typedef struct {
+  uv_buf_t buf;
+  int64_t pos;
+  size_t bytes;
+  uint32_t index;
+} bare_fs_many_op_t;
+
+typedef struct {
+  uv_file fd;
+  bool write;
+
+  int32_t *results;
+
+  uint32_t len;
+  bare_fs_many_op_t ops[];
+} bare_fs_many_t;
+
 typedef struct {
   uv_dir_t *handle;
+
+  // A descriptor of the directory, opened along with it, to stat entries
+  // relative to, as that of the directory stream is private to libuv. Only
+  // used on POSIX and -1 if it couldn't be opened.
+  uv_file fd;
 } bare_fs_dir_t;
 
+typedef struct {
+  bare_fs_path_t path;
+  uv_file fd;
+} bare_fs_opendir_t;
+
+typedef struct {
+  uv_dir_t *dir;
+  uv_file fd;
+  bare_fs_path_t path;
+
+  // The stats of each entry read, `BARE_FS_STAT_FIELDS` per entry.
+  double *stats;
+} bare_fs_readdir_stats_t;
+
 typedef struct {
   uv_fs_event_t handle;
 
@@ -41,6 +239,7 @@ typedef struct {
 
   bool exiting;
   bool closing;
+  bool utf8;
 
   js_deferred_teardown_t *teardown;
 } bare_fs_watcher_t;
@@ -84,7 +283,8 @@ bare_fs__on_request_teardown(js_deferred_teardown_t *handle, void *data) {
   // pending callback to operate on freed memory, so we only attempt to cancel
   // the work to hurry it along and defer destruction to the result callback.
   if (req->inflight) {
-    uv_cancel((uv_req_t *) &req->handle);
+    if (req->working) uv_cancel((uv_req_t *) &req->work);
+    else uv_cancel((uv_req_t *) &req->handle);
 
     return;
   }
@@ -120,7 +320,7 @@ bare_fs__on_request_result(uv_fs_t *handle) {
 
   js_value_t *args[2];
 
-  if (status < 0) {
+  if (status < 0 && !req->probe) {
     js_value_t *code;
     err = js_create_string_utf8(env, (utf8_t *) uv_err_name(status), -1, &code);
     assert(err == 0);
@@ -146,6 +346,35 @@ bare_fs__on_request_result(uv_fs_t *handle) {
   assert(err == 0);
 }
 
+static void
+bare_fs__on_work_result(uv_work_t *handle, int status) {
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  req->working = false;
+
+  if (status < 0) req->handle.result = status;
+
+  bare_fs__on_request_result(&req->handle);
+}
+
+static inline void
+bare_fs__request_work(uv_loop_t *loop, bare_fs_req_t *req, uv_work_cb cb, bool async) {
+  int err;
+
+  req->work.data = req;
+
+  if (async) {
+    req->working = true;
+
+    err = uv_queue_work(loop, &req->work, cb, bare_fs__on_work_result);
+    assert(err == 0);
+  } else {
+    req->work.loop = loop;
+
+    cb(&req->work);
+  }
+}
+
 static inline int
 bare_fs__request_pending(js_env_t *env, bare_fs_req_t *req, bool async, int *result) {
   int err;
@@ -159,8 +388,10 @@ bare_fs__request_pending(js_env_t *env, bare_fs_req_t *req, bool async, int *res
   int status = req->handle.result;
 
   if (status < 0) {
-    err = js_throw_error(env, uv_err_name(status), uv_strerror(status));
-    assert(err == 0);
+    if (!req->probe) {
+      err = js_throw_error(env, uv_err_name(status), uv_strerror(status));
+      assert(err == 0);
+    }
 
     return -1;
   }
@@ -189,8 +420,11 @@ bare_fs_request_init(js_env_t *env, js_callback_info_t *info) {
   assert(err == 0);
 
   req->env = env;
+  req->job = NULL;
   req->exiting = false;
   req->inflight = false;
+  req->working = false;
+  req->probe = false;
 
   err = js_create_reference(env, argv[0], 1, &req->ctx);
   assert(err == 0);
@@ -243,9 +477,55 @@ bare_fs_request_reset(js_env_t *env, js_callback_info_t *info) {
 
   uv_fs_req_cleanup(&req->handle);
 
+  req->probe = false;
+
+  return NULL;
+}
+
+static js_value_t *
+bare_fs_request_probe(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 1;
+  js_value_t *argv[1];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 1);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  req->probe = true;
+
   return NULL;
 }
 
+static js_value_t *
+bare_fs_request_result_status(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 1;
+  js_value_t *argv[1];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 1);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+  err = js_create_int32(env, (int32_t) req->handle.result, &result);
+  assert(err == 0);
+
+  return result;
+}
+
 static js_value_t *
 bare_fs_request_result_stat(js_env_t *env, js_callback_info_t *info) {
   int err;
@@ -309,6 +589,31 @@ bare_fs_request_result_stat(js_env_t *env, js_callback_info_t *info) {
   return result;
 }
 
+static inline void
+bare_fs__stat_fields(const uv_stat_t *st, double *fields) {
+  uint32_t i = 0;
+
+#define V(property) fields[i++] = (double) st->st_##property;
+  V(dev)
+  V(mode)
+  V(nlink)
+  V(uid)
+  V(gid)
+  V(rdev)
+  V(blksize)
+  V(ino)
+  V(size)
+  V(blocks)
+#undef V
+
+#define V(property) fields[i++] = (double) (st->st_##property.tv_sec * 1000 + st->st_##property.tv_nsec / 1000000);
+  V(atim)
+  V(mtim)
+  V(ctim)
+  V(birthtim)
+#undef V
+}
+
 static js_value_t *
 bare_fs_request_result_statfs(js_env_t *env, js_callback_info_t *info) {
   int err;
@@ -384,6 +689,60 @@ bare_fs_request_result_string(js_env_t *env, js_callback_info_t *info) {
   return result;
 }
 
+static js_value_t *
+bare_fs_request_result_string_utf8(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 1;
+  js_value_t *argv[1];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 1);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  const char *str = req->handle.ptr;
+
+  js_value_t *result;
+  err = js_create_string_utf8(env, (utf8_t *) str, strlen(str), &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_request_result_digest(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 1;
+  js_value_t *argv[1];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 1);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  bare_fs_hash_file_t *job = req->job;
+
+  js_value_t *result;
+
+  void *data;
+  err = js_create_arraybuffer(env, job->digest_len, &data, &result);
+  assert(err == 0);
+
+  memcpy(data, job->digest, job->digest_len);
+
+  return result;
+}
+
 static js_value_t *
 bare_fs_request_result_path(js_env_t *env, js_callback_info_t *info) {
   int err;
@@ -433,6 +792,10 @@ bare_fs_request_result_dir(js_env_t *env, js_callback_info_t *info) {
 
   dir->handle = req->handle.ptr;
 
+  bare_fs_opendir_t *job = req->job;
+
+  dir->fd = job->fd;
+
   return result;
 }
 
@@ -440,18 +803,22 @@ static js_value_t *
 bare_fs_request_result_dirents(js_env_t *env, js_callback_info_t *info) {
   int err;
 
-  size_t argc = 1;
-  js_value_t *argv[1];
+  size_t argc = 2;
+  js_value_t *argv[2];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 1);
+  assert(argc == 2);
 
   bare_fs_req_t *req;
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
   assert(err == 0);
 
+  bool utf8;
+  err = js_get_value_bool(env, argv[1], &utf8);
+  assert(err == 0);
+
   size_t len = req->handle.result;
 
   js_value_t *result;
@@ -474,11 +841,18 @@ bare_fs_request_result_dirents(js_env_t *env, js_callback_info_t *info) {
 
     js_value_t *name;
 
-    void *data;
-    err = js_create_arraybuffer(env, name_len, &data, &name);
-    assert(err == 0);
+    // Names are created as strings directly when decoded as UTF-8 anyway,
+    // saving a copy.
+    if (utf8) {
+      err = js_create_string_utf8(env, (utf8_t *) dirent->name, name_len, &name);
+      assert(err == 0);
+    } else {
+      void *data;
+      err = js_create_arraybuffer(env, name_len, &data, &name);
+      assert(err == 0);
 
-    memcpy(data, dirent->name, name_len);
+      memcpy(data, dirent->name, name_len);
+    }
 
     err = js_set_named_property(env, entry, "name", name);
     assert(err == 0);
@@ -981,44 +1355,273 @@ bare_fs_writev_sync(js_env_t *env, js_callback_info_t *info) {
   return bare_fs__writev(env, info, bare_fs_sync);
 }
 
-static void
-bare_fs__on_ftruncate(uv_fs_t *handle) {
-  bare_fs__on_request_result(handle);
+static int
+bare_fs__compare_many_op_position(const void *a, const void *b) {
+  const bare_fs_many_op_t *x = a, *y = b;
+
+  if (x->pos != y->pos) return x->pos < y->pos ? -1 : 1;
+
+  return x->index < y->index ? -1 : x->index > y->index;
 }
 
-static inline js_value_t *
-bare_fs__ftruncate(js_env_t *env, js_callback_info_t *info, bool async) {
+static int
+bare_fs__compare_many_op_index(const void *a, const void *b) {
+  const bare_fs_many_op_t *x = a, *y = b;
+
+  return x->index < y->index ? -1 : x->index > y->index;
+}
+
+#define BARE_FS_MANY_MAX_BUFS 1024
+
+static void
+bare_fs__many_work(uv_work_t *handle) {
   int err;
 
-  size_t argc = 3;
-  js_value_t *argv[3];
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
 
-  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
-  assert(err == 0);
+  bare_fs_many_t *job = req->job;
 
-  assert(argc == 3);
+  bare_fs_many_op_t *ops = job->ops;
 
-  bare_fs_req_t *req;
-  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
-  assert(err == 0);
+  // Sort the operations by position so that adjacent ranges can be merged
+  // into a single vectored call. Overlapping writes must land in the order
+  // they were given, so in that case the original order is kept.
+  qsort(ops, job->len, sizeof(bare_fs_many_op_t), bare_fs__compare_many_op_position);
 
-  uint32_t fd;
-  err = js_get_value_uint32(env, argv[1], &fd);
-  assert(err == 0);
+  if (job->write) {
+    for (uint32_t i = 1; i < job->len; i++) {
+      if (ops[i].pos < ops[i - 1].pos + (int64_t) ops[i - 1].buf.len) {
+        qsort(ops, job->len, sizeof(bare_fs_many_op_t), bare_fs__compare_many_op_index);
 
-  int64_t len;
-  err = js_get_value_int64(env, argv[2], &len);
-  assert(err == 0);
+        break;
+      }
+    }
+  }
 
-  uv_loop_t *loop;
-  err = js_get_env_loop(env, &loop);
-  assert(err == 0);
+  uv_buf_t *bufs = malloc(sizeof(uv_buf_t) * BARE_FS_MANY_MAX_BUFS);
 
-  err = uv_fs_ftruncate(loop, &req->handle, fd, len, async ? bare_fs__on_ftruncate : NULL);
-  (void) err;
+  uv_fs_t fs;
 
-  err = bare_fs__request_pending(env, req, async, NULL);
-  (void) err;
+  int status = bufs == NULL ? UV_ENOMEM : 0;
+
+  uint32_t i = 0;
+
+  while (status == 0 && i < job->len) {
+    bare_fs_many_op_t *op = &ops[i];
+
+    if (op->bytes == op->buf.len) {
+      i++;
+
+      continue;
+    }
+
+    int64_t pos = op->pos + op->bytes;
+
+    uint32_t n = 0, j = i + 1;
+
+    bufs[n++] = uv_buf_init(op->buf.base + op->bytes, op->buf.len - op->bytes);
+
+    while (j < job->len && n < BARE_FS_MANY_MAX_BUFS && ops[j].pos == ops[j - 1].pos + (int64_t) ops[j - 1].buf.len) {
+      bufs[n++] = ops[j++].buf;
+    }
+
+    if (job->write) {
+      err = uv_fs_write(handle->loop, &fs, job->fd, bufs, n, pos, NULL);
+    } else {
+      err = uv_fs_read(handle->loop, &fs, job->fd, bufs, n, pos, NULL);
+    }
+
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) {
+      status = err;
+
+      break;
+    }
+
+    if (err == 0) {
+      if (job->write) {
+        status = UV_EIO;
+
+        break;
+      }
+
+      // End of file, the remaining operations in the run read nothing.
+      i = j;
+
+      continue;
+    }
+
+    size_t missing = err;
+
+    for (uint32_t k = i; k < j && missing > 0; k++) {
+      size_t len = ops[k].buf.len - ops[k].bytes;
+
+      if (len > missing) len = missing;
+
+      ops[k].bytes += len;
+
+      missing -= len;
+    }
+  }
+
+  free(bufs);
+
+  if (status == 0) {
+    for (uint32_t k = 0; k < job->len; k++) {
+      job->results[ops[k].index] = (int32_t) ops[k].bytes;
+    }
+  }
+
+  req->handle.result = status;
+}
+
+static inline js_value_t *
+bare_fs__many(js_env_t *env, js_callback_info_t *info, bool async, bool write) {
+  int err;
+
+  size_t argc = 5;
+  js_value_t *argv[5];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 5);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  uint32_t len;
+  err = js_get_array_length(env, argv[2], &len);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_many_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_many_t) + len * sizeof(bare_fs_many_op_t), (void **) &job, &result);
+  assert(err == 0);
+
+  job->write = write;
+  job->len = len;
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[4], NULL, (void **) &job->results, NULL, NULL, NULL);
+  assert(err == 0);
+
+  js_value_t **elements = malloc(len * 2 * sizeof(js_value_t *));
+
+  if (elements == NULL && len > 0) {
+    err = js_throw_error(env, uv_err_name(UV_ENOMEM), uv_strerror(UV_ENOMEM));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  err = js_get_array_elements(env, argv[2], elements, len, 0, NULL);
+  assert(err == 0);
+
+  err = js_get_array_elements(env, argv[3], &elements[len], len, 0, NULL);
+  assert(err == 0);
+
+  for (uint32_t i = 0; i < len; i++) {
+    bare_fs_many_op_t *op = &job->ops[i];
+
+    // The length of a buffer is a `ULONG` on Windows, narrower than `size_t`,
+    // so it can't be written to directly.
+    size_t buf_len;
+    err = js_get_typedarray_info(env, elements[i], NULL, (void **) &op->buf.base, &buf_len, NULL, NULL);
+    assert(err == 0);
+
+#ifdef _WIN32
+    op->buf.len = (ULONG) buf_len;
+#else
+    op->buf.len = buf_len;
+#endif
+
+    err = js_get_value_int64(env, elements[len + i], &op->pos);
+    assert(err == 0);
+
+    op->bytes = 0;
+    op->index = i;
+  }
+
+  free(elements);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__many_work, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_read_many(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__many(env, info, bare_fs_async, false);
+}
+
+static js_value_t *
+bare_fs_read_many_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__many(env, info, bare_fs_sync, false);
+}
+
+static js_value_t *
+bare_fs_write_many(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__many(env, info, bare_fs_async, true);
+}
+
+static js_value_t *
+bare_fs_write_many_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__many(env, info, bare_fs_sync, true);
+}
+
+static void
+bare_fs__on_ftruncate(uv_fs_t *handle) {
+  bare_fs__on_request_result(handle);
+}
+
+static inline js_value_t *
+bare_fs__ftruncate(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 3;
+  js_value_t *argv[3];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 3);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  uint32_t fd;
+  err = js_get_value_uint32(env, argv[1], &fd);
+  assert(err == 0);
+
+  int64_t len;
+  err = js_get_value_int64(env, argv[2], &len);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  err = uv_fs_ftruncate(loop, &req->handle, fd, len, async ? bare_fs__on_ftruncate : NULL);
+  (void) err;
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
 
   return NULL;
 }
@@ -2174,23 +2777,48 @@ bare_fs_symlink_sync(js_env_t *env, js_callback_info_t *info) {
 }
 
 static void
-bare_fs__on_opendir(uv_fs_t *handle) {
+bare_fs__opendir_work(uv_work_t *handle) {
   int err;
 
-  bare_fs_req_t *req = (bare_fs_req_t *) handle;
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
 
-  int status = handle->result;
+  bare_fs_opendir_t *job = req->job;
 
-  if (req->exiting && status >= 0) {
-    uv_dir_t *dir = handle->ptr;
+  err = uv_fs_opendir(handle->loop, &req->handle, (char *) job->path, NULL);
 
-    uv_fs_req_cleanup(handle);
+#ifndef _WIN32
+  job->fd = err < 0 ? -1 : open((char *) job->path, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+#else
+  job->fd = -1;
+#endif
+}
+
+static void
+bare_fs__on_opendir(uv_work_t *handle, int status) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  req->working = false;
 
-    err = uv_fs_closedir(handle->loop, handle, dir, NULL);
+  if (status < 0) req->handle.result = status;
+
+  if (req->exiting && req->handle.result >= 0) {
+    bare_fs_opendir_t *job = req->job;
+
+#ifndef _WIN32
+    if (job->fd != -1) close(job->fd);
+#endif
+
+    uv_dir_t *dir = req->handle.ptr;
+
+    uv_fs_req_cleanup(&req->handle);
+
+    err = uv_fs_closedir(handle->loop, &req->handle, dir, NULL);
     assert(err == 0);
   }
 
-  bare_fs__on_request_result(handle);
+  bare_fs__on_request_result(&req->handle);
 }
 
 static inline js_value_t *
@@ -2209,21 +2837,41 @@ bare_fs__opendir(js_env_t *env, js_callback_info_t *info, bool async) {
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
   assert(err == 0);
 
-  bare_fs_path_t path;
-  err = js_get_value_string_utf8(env, argv[1], path, sizeof(bare_fs_path_t), NULL);
+  js_value_t *result;
+
+  bare_fs_opendir_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_opendir_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_string_utf8(env, argv[1], job->path, sizeof(bare_fs_path_t), NULL);
   assert(err == 0);
 
+  job->fd = -1;
+
   uv_loop_t *loop;
   err = js_get_env_loop(env, &loop);
   assert(err == 0);
 
-  err = uv_fs_opendir(loop, &req->handle, (char *) path, async ? bare_fs__on_opendir : NULL);
-  (void) err;
+  req->job = job;
+  req->work.data = req;
+
+  // The directory is opened as work rather than through libuv alone, so that
+  // its descriptor can be opened on the threadpool too.
+  if (async) {
+    req->working = true;
+
+    err = uv_queue_work(loop, &req->work, bare_fs__opendir_work, bare_fs__on_opendir);
+    assert(err == 0);
+  } else {
+    req->work.loop = loop;
+
+    bare_fs__opendir_work(&req->work);
+  }
 
   err = bare_fs__request_pending(env, req, async, NULL);
   (void) err;
 
-  return NULL;
+  return result;
 }
 
 static js_value_t *
@@ -2245,13 +2893,13 @@ static inline js_value_t *
 bare_fs__readdir(js_env_t *env, js_callback_info_t *info, bool async) {
   int err;
 
-  size_t argc = 3;
-  js_value_t *argv[3];
+  size_t argc = 4;
+  js_value_t *argv[4];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 3);
+  assert(argc == 4);
 
   bare_fs_req_t *req;
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
@@ -2261,14 +2909,12 @@ bare_fs__readdir(js_env_t *env, js_callback_info_t *info, bool async) {
   err = js_get_arraybuffer_info(env, argv[1], (void **) &dir, NULL);
   assert(err == 0);
 
-  uint32_t capacity;
-  err = js_get_value_uint32(env, argv[2], &capacity);
+  bare_fs_dirent_t *dirents;
+  err = js_get_arraybuffer_info(env, argv[2], (void **) &dirents, NULL);
   assert(err == 0);
 
-  js_value_t *result;
-
-  bare_fs_dirent_t *dirents;
-  err = js_create_arraybuffer(env, capacity * sizeof(bare_fs_dirent_t), (void **) &dirents, &result);
+  uint32_t capacity;
+  err = js_get_value_uint32(env, argv[3], &capacity);
   assert(err == 0);
 
   uv_loop_t *loop;
@@ -2284,7 +2930,7 @@ bare_fs__readdir(js_env_t *env, js_callback_info_t *info, bool async) {
   err = bare_fs__request_pending(env, req, async, NULL);
   (void) err;
 
-  return result;
+  return NULL;
 }
 
 static js_value_t *
@@ -2297,22 +2943,155 @@ bare_fs_readdir_sync(js_env_t *env, js_callback_info_t *info) {
   return bare_fs__readdir(env, info, bare_fs_sync);
 }
 
+#ifndef _WIN32
+
+static inline void
+bare_fs__to_uv_stat(const struct stat *st, uv_stat_t *result) {
+  memset(result, 0, sizeof(uv_stat_t));
+
+  result->st_dev = st->st_dev;
+  result->st_mode = st->st_mode;
+  result->st_nlink = st->st_nlink;
+  result->st_uid = st->st_uid;
+  result->st_gid = st->st_gid;
+  result->st_rdev = st->st_rdev;
+  result->st_blksize = st->st_blksize;
+  result->st_ino = st->st_ino;
+  result->st_size = st->st_size;
+  result->st_blocks = st->st_blocks;
+
+#if defined(__APPLE__)
+#define V(property) \
+  result->st_##property##im.tv_sec = st->st_##property##imespec.tv_sec; \
+  result->st_##property##im.tv_nsec = st->st_##property##imespec.tv_nsec;
+  V(at)
+  V(mt)
+  V(ct)
+  V(birtht)
+#undef V
+#else
+#define V(property) \
+  result->st_##property##im.tv_sec = st->st_##property##im.tv_sec; \
+  result->st_##property##im.tv_nsec = st->st_##property##im.tv_nsec;
+  V(at)
+  V(mt)
+  V(ct)
+#undef V
+
+  // Like libuv, fall back to the change time where the birth time isn't
+  // available.
+  result->st_birthtim = result->st_ctim;
+#endif
+}
+
+static inline uv_dirent_type_t
+bare_fs__dirent_type(mode_t mode) {
+  switch (mode & S_IFMT) {
+  case S_IFREG:
+    return UV_DIRENT_FILE;
+  case S_IFDIR:
+    return UV_DIRENT_DIR;
+  case S_IFLNK:
+    return UV_DIRENT_LINK;
+  case S_IFIFO:
+    return UV_DIRENT_FIFO;
+  case S_IFSOCK:
+    return UV_DIRENT_SOCKET;
+  case S_IFCHR:
+    return UV_DIRENT_CHAR;
+  case S_IFBLK:
+    return UV_DIRENT_BLOCK;
+  default:
+    return UV_DIRENT_UNKNOWN;
+  }
+}
+
+#endif
+
 static void
-bare_fs__on_closedir(uv_fs_t *handle) {
-  bare_fs__on_request_result(handle);
+bare_fs__readdir_stats_work(uv_work_t *handle) {
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_readdir_stats_t *job = req->job;
+
+  // Read the entries into the request itself, so that they are cleaned up
+  // with it and can be retrieved as for a plain readdir.
+  int len = uv_fs_readdir(handle->loop, &req->handle, job->dir, NULL);
+
+#ifndef _WIN32
+  // Entries of directories without a descriptor report all zeros like removed
+  // entries.
+  int fd = job->fd;
+#else
+  size_t path_len = strlen((char *) job->path);
+#endif
+
+  for (int i = 0; i < len; i++) {
+    uv_dirent_t *dirent = &job->dir->dirents[i];
+
+    double *fields = &job->stats[i * BARE_FS_STAT_FIELDS];
+
+    uv_stat_t st;
+
+#ifndef _WIN32
+    struct stat buf;
+
+    // Entries removed after being read report all zeros.
+    if (fstatat(fd, dirent->name, &buf, AT_SYMLINK_NOFOLLOW) == -1) {
+      memset(fields, 0, BARE_FS_STAT_FIELDS * sizeof(double));
+
+      continue;
+    }
+
+    bare_fs__to_uv_stat(&buf, &st);
+
+    // Some file systems don't report the type of entries, so take it from the
+    // stats instead.
+    if (dirent->type == UV_DIRENT_UNKNOWN) dirent->type = bare_fs__dirent_type(buf.st_mode);
+#else
+    size_t name_len = strlen(dirent->name);
+
+    if (path_len + 1 + name_len >= sizeof(bare_fs_path_t)) {
+      memset(fields, 0, BARE_FS_STAT_FIELDS * sizeof(double));
+
+      continue;
+    }
+
+    bare_fs_path_t path;
+
+    memcpy(path, job->path, path_len);
+    path[path_len] = '\\';
+    memcpy(&path[path_len + 1], dirent->name, name_len + 1);
+
+    uv_fs_t fs;
+    int err = uv_fs_lstat(handle->loop, &fs, (char *) path, NULL);
+
+    st = fs.statbuf;
+
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) {
+      memset(fields, 0, BARE_FS_STAT_FIELDS * sizeof(double));
+
+      continue;
+    }
+#endif
+
+    bare_fs__stat_fields(&st, fields);
+  }
 }
 
 static inline js_value_t *
-bare_fs__closedir(js_env_t *env, js_callback_info_t *info, bool async) {
+bare_fs__readdir_stats(js_env_t *env, js_callback_info_t *info, bool async) {
   int err;
 
-  size_t argc = 2;
-  js_value_t *argv[2];
+  size_t argc = 6;
+  js_value_t *argv[6];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 2);
+  assert(argc == 6);
 
   bare_fs_req_t *req;
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
@@ -2322,123 +3101,1946 @@ bare_fs__closedir(js_env_t *env, js_callback_info_t *info, bool async) {
   err = js_get_arraybuffer_info(env, argv[1], (void **) &dir, NULL);
   assert(err == 0);
 
-  uv_loop_t *loop;
-  err = js_get_env_loop(env, &loop);
+  js_value_t *result;
+
+  bare_fs_readdir_stats_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_readdir_stats_t), (void **) &job, &result);
   assert(err == 0);
 
-  err = uv_fs_closedir(loop, &req->handle, dir->handle, async ? bare_fs__on_closedir : NULL);
-  (void) err;
+  job->dir = dir->handle;
+  job->fd = dir->fd;
 
-  err = bare_fs__request_pending(env, req, async, NULL);
-  (void) err;
+  err = js_get_value_string_utf8(env, argv[2], job->path, sizeof(bare_fs_path_t), NULL);
+  assert(err == 0);
 
-  return NULL;
-}
+  bare_fs_dirent_t *dirents;
+  err = js_get_arraybuffer_info(env, argv[3], (void **) &dirents, NULL);
+  assert(err == 0);
 
-static js_value_t *
-bare_fs_closedir(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__closedir(env, info, bare_fs_async);
-}
+  uint32_t capacity;
+  err = js_get_value_uint32(env, argv[4], &capacity);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[5], NULL, (void **) &job->stats, NULL, NULL, NULL);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  dir->handle->dirents = dirents;
+  dir->handle->nentries = capacity;
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__readdir_stats_work, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_readdir_stats(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__readdir_stats(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_readdir_stats_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__readdir_stats(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__on_closedir(uv_fs_t *handle) {
+  bare_fs__on_request_result(handle);
+}
+
+static inline js_value_t *
+bare_fs__closedir(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  bare_fs_dir_t *dir;
+  err = js_get_arraybuffer_info(env, argv[1], (void **) &dir, NULL);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+#ifndef _WIN32
+  if (dir->fd != -1) close(dir->fd);
+#endif
+
+  dir->fd = -1;
+
+  err = uv_fs_closedir(loop, &req->handle, dir->handle, async ? bare_fs__on_closedir : NULL);
+  (void) err;
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return NULL;
+}
+
+static js_value_t *
+bare_fs_closedir(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__closedir(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_closedir_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__closedir(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__on_fsync(uv_fs_t *handle) {
+  bare_fs__on_request_result(handle);
+}
+
+static inline js_value_t *
+bare_fs__fsync(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  uint32_t fd;
+  err = js_get_value_uint32(env, argv[1], &fd);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  err = uv_fs_fsync(loop, &req->handle, fd, async ? bare_fs__on_fsync : NULL);
+  (void) err;
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return NULL;
+}
+
+static js_value_t *
+bare_fs_fsync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__fsync(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_fsync_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__fsync(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__on_fdatasync(uv_fs_t *handle) {
+  bare_fs__on_request_result(handle);
+}
+
+static inline js_value_t *
+bare_fs__fdatasync(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  uint32_t fd;
+  err = js_get_value_uint32(env, argv[1], &fd);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  err = uv_fs_fdatasync(loop, &req->handle, fd, async ? bare_fs__on_fdatasync : NULL);
+  (void) err;
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return NULL;
+}
+
+static js_value_t *
+bare_fs_fdatasync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__fdatasync(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_fdatasync_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__fdatasync(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__hash_file_work(uv_work_t *handle) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_hash_file_t *job = req->job;
+
+  uv_fs_t fs;
+
+  uv_file fd = job->fd;
+
+  if (fd < 0) {
+    err = uv_fs_open(handle->loop, &fs, (char *) job->path, UV_FS_O_RDONLY, 0, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) {
+      req->handle.result = err;
+
+      return;
+    }
+
+    fd = err;
+  }
+
+  size_t capacity = 256 * 1024;
+
+  uint8_t *data = malloc(capacity);
+
+  int64_t pos = job->offset;
+  int64_t missing = job->length;
+
+  int status = data == NULL ? UV_ENOMEM : 0;
+
+  while (status == 0 && missing != 0) {
+    size_t len = capacity;
+
+    if (missing > 0 && (uint64_t) missing < len) len = (size_t) missing;
+
+    uv_buf_t buf = uv_buf_init((void *) data, len);
+
+    err = uv_fs_read(handle->loop, &fs, fd, &buf, 1, pos, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err <= 0) {
+      status = err;
+
+      break;
+    }
+
+    bare_fs_hash_update(&job->hash, data, err);
+
+    pos += err;
+
+    if (missing > 0) missing -= err;
+  }
+
+  free(data);
+
+  if (job->fd < 0) {
+    err = uv_fs_close(handle->loop, &fs, fd, NULL);
+    (void) err;
+
+    uv_fs_req_cleanup(&fs);
+  }
+
+  if (status == 0) bare_fs_hash_final(&job->hash, job->digest);
+
+  req->handle.result = status;
+}
+
+static inline js_value_t *
+bare_fs__hash_file(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 6;
+  js_value_t *argv[6];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 6);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_hash_file_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_hash_file_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  err = js_get_value_string_utf8(env, argv[2], job->path, sizeof(bare_fs_path_t), NULL);
+  assert(err == 0);
+
+  uint32_t algorithm;
+  err = js_get_value_uint32(env, argv[3], &algorithm);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[4], &job->offset);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[5], &job->length);
+  assert(err == 0);
+
+  job->digest_len = bare_fs_hash_init(&job->hash, algorithm);
+  assert(job->digest_len > 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__hash_file_work, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_hash_file(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__hash_file(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_hash_file_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__hash_file(env, info, bare_fs_sync);
+}
+
+static js_value_t *
+bare_fs_hash(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  uint32_t algorithm;
+  err = js_get_value_uint32(env, argv[0], &algorithm);
+  assert(err == 0);
+
+  uint8_t *data;
+  size_t len;
+  err = js_get_typedarray_info(env, argv[1], NULL, (void **) &data, &len, NULL, NULL);
+  assert(err == 0);
+
+  bare_fs_hash_t hash;
+
+  size_t digest_len = bare_fs_hash_init(&hash, algorithm);
+  assert(digest_len > 0);
+
+  bare_fs_hash_update(&hash, data, len);
+
+  js_value_t *result;
+
+  void *digest;
+  err = js_create_arraybuffer(env, digest_len, &digest, &result);
+  assert(err == 0);
+
+  bare_fs_hash_final(&hash, digest);
+
+  return result;
+}
+
+static int
+bare_fs__fallocate_file(uv_file fd, int mode, int64_t offset, int64_t length) {
+#if defined(__linux__)
+  int flags = 0;
+
+  if (mode & bare_fs_fallocate_keep_size) flags |= FALLOC_FL_KEEP_SIZE;
+  if (mode & bare_fs_fallocate_punch_hole) flags |= FALLOC_FL_PUNCH_HOLE | FALLOC_FL_KEEP_SIZE;
+  if (mode & bare_fs_fallocate_zero_range) flags |= FALLOC_FL_ZERO_RANGE;
+  if (mode & bare_fs_fallocate_collapse_range) flags |= FALLOC_FL_COLLAPSE_RANGE;
+
+  if (fallocate(fd, flags, offset, length) == -1) return uv_translate_sys_error(errno);
+
+  return 0;
+#elif defined(__APPLE__)
+  if (mode & ~bare_fs_fallocate_keep_size) return UV_ENOTSUP;
+
+  struct stat st;
+
+  if (fstat(fd, &st) == -1) return uv_translate_sys_error(errno);
+
+  int64_t end = offset + length;
+
+  if (end <= st.st_size) return 0;
+
+  // F_PREALLOCATE allocates relative to the end of the file, so only the
+  // part of the range past the end needs to be reserved. Ask for
+  // contiguous space first and fall back to any space.
+  fstore_t store = {
+    .fst_flags = F_ALLOCATECONTIG | F_ALLOCATEALL,
+    .fst_posmode = F_PEOFPOSMODE,
+    .fst_offset = 0,
+    .fst_length = end - st.st_size,
+  };
+
+  if (fcntl(fd, F_PREALLOCATE, &store) == -1) {
+    store.fst_flags = F_ALLOCATEALL;
+
+    if (fcntl(fd, F_PREALLOCATE, &store) == -1) return uv_translate_sys_error(errno);
+  }
+
+  if (mode & bare_fs_fallocate_keep_size) return 0;
+
+  if (ftruncate(fd, end) == -1) return uv_translate_sys_error(errno);
+
+  return 0;
+#elif defined(_WIN32)
+  if (mode & ~bare_fs_fallocate_keep_size) return UV_ENOTSUP;
+
+  HANDLE handle = (HANDLE) uv_get_osfhandle(fd);
+
+  FILE_STANDARD_INFO st;
+
+  if (!GetFileInformationByHandleEx(handle, FileStandardInfo, &st, sizeof(st))) {
+    return uv_translate_sys_error(GetLastError());
+  }
+
+  int64_t end = offset + length;
+
+  // Lowering the allocation size below the end of the file truncates it, so
+  // it is only ever raised.
+  if (end > st.AllocationSize.QuadPart) {
+    FILE_ALLOCATION_INFO info;
+    info.AllocationSize.QuadPart = end;
+
+    if (!SetFileInformationByHandle(handle, FileAllocationInfo, &info, sizeof(info))) {
+      return uv_translate_sys_error(GetLastError());
+    }
+  }
+
+  if ((mode & bare_fs_fallocate_keep_size) || end <= st.EndOfFile.QuadPart) return 0;
+
+  FILE_END_OF_FILE_INFO info;
+  info.EndOfFile.QuadPart = end;
+
+  if (!SetFileInformationByHandle(handle, FileEndOfFileInfo, &info, sizeof(info))) {
+    return uv_translate_sys_error(GetLastError());
+  }
+
+  return 0;
+#else
+  if (mode != 0) return UV_ENOTSUP;
+
+  int err = posix_fallocate(fd, offset, length);
+
+  if (err != 0) return uv_translate_sys_error(err);
+
+  return 0;
+#endif
+}
+
+static void
+bare_fs__fallocate_work(uv_work_t *handle) {
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_file_range_t *job = req->job;
+
+  req->handle.result = bare_fs__fallocate_file(job->fd, job->mode, job->offset, job->length);
+}
+
+static inline js_value_t *
+bare_fs__file_range(js_env_t *env, js_callback_info_t *info, bool async, uv_work_cb cb) {
+  int err;
+
+  size_t argc = 5;
+  js_value_t *argv[5];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 5);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_file_range_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_file_range_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[2], &job->offset);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[3], &job->length);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[4], &job->mode);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, cb, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_fallocate(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__file_range(env, info, bare_fs_async, bare_fs__fallocate_work);
+}
+
+static js_value_t *
+bare_fs_fallocate_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__file_range(env, info, bare_fs_sync, bare_fs__fallocate_work);
+}
+
+static int
+bare_fs__writeback_file(uv_loop_t *loop, uv_file fd, int mode, int64_t offset, int64_t length) {
+  int err;
+
+#if defined(__linux__)
+  unsigned int flags = SYNC_FILE_RANGE_WRITE;
+
+  if (mode & bare_fs_writeback_wait) flags |= SYNC_FILE_RANGE_WAIT_BEFORE | SYNC_FILE_RANGE_WAIT_AFTER;
+
+  if (sync_file_range(fd, offset, length, flags) == -1) return uv_translate_sys_error(errno);
+#else
+  // Write-back can't be started for just a range of the file, so only waiting
+  // is honoured, by flushing the whole file.
+  if (mode & bare_fs_writeback_wait) {
+    uv_fs_t fs;
+    err = uv_fs_fdatasync(loop, &fs, fd, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) return err;
+  }
+#endif
+
+#if defined(POSIX_FADV_DONTNEED)
+  if (mode & bare_fs_writeback_drop) {
+    err = posix_fadvise(fd, offset, length, POSIX_FADV_DONTNEED);
+
+    if (err != 0) return uv_translate_sys_error(err);
+  }
+#endif
+
+  return 0;
+}
+
+static void
+bare_fs__writeback_work(uv_work_t *handle) {
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_file_range_t *job = req->job;
+
+  req->handle.result = bare_fs__writeback_file(handle->loop, job->fd, job->mode, job->offset, job->length);
+}
+
+static js_value_t *
+bare_fs_writeback(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__file_range(env, info, bare_fs_async, bare_fs__writeback_work);
+}
+
+static js_value_t *
+bare_fs_writeback_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__file_range(env, info, bare_fs_sync, bare_fs__writeback_work);
+}
+
+// Report the remainder of the file from `offset` as a single range of data,
+// for files that can't be seeked for holes.
+static int
+bare_fs__rest_data_range(uv_loop_t *loop, uv_file fd, int64_t offset, int64_t *start, int64_t *end) {
+  int err;
+
+  uv_fs_t fs;
+  err = uv_fs_fstat(loop, &fs, fd, NULL);
+
+  int64_t size = fs.statbuf.st_size;
+
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) return err;
+
+  if (offset >= size) return 1;
+
+  *start = offset;
+  *end = size;
+
+  return 0;
+}
+
+// Find the first range of data at or after `offset`, storing its bounds in
+// `start` and `end`. Returns 1 if there is no more data and 0 otherwise. On
+// platforms without SEEK_DATA the remainder of the file is reported as data.
+//
+// This moves the offset of `fd`, so it must not be shared with other users.
+static int
+bare_fs__next_data_range(uv_loop_t *loop, uv_file fd, int64_t offset, int64_t *start, int64_t *end) {
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  off_t data = lseek(fd, offset, SEEK_DATA);
+
+  if (data == -1) {
+    if (errno == ENXIO) return 1;
+
+    return uv_translate_sys_error(errno);
+  }
+
+  off_t hole = lseek(fd, data, SEEK_HOLE);
+
+  if (hole == -1) return uv_translate_sys_error(errno);
+
+  *start = data;
+  *end = hole;
+
+  return 0;
+#else
+  return bare_fs__rest_data_range(loop, fd, offset, start, end);
+#endif
+}
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+
+// Open the file of `fd` again, returning a descriptor with an offset of its
+// own, or -1 if the file can't be reopened.
+static int
+bare_fs__reopen(int fd) {
+#if defined(__linux__)
+  char path[32];
+  snprintf(path, sizeof(path), "/proc/self/fd/%d", fd);
+#elif defined(F_GETPATH)
+  char path[MAXPATHLEN];
+  if (fcntl(fd, F_GETPATH, path) == -1) return -1;
+#else
+  return -1;
+#endif
+
+#if defined(__linux__) || defined(F_GETPATH)
+  return open(path, O_RDONLY | O_CLOEXEC);
+#endif
+}
+
+#endif
+
+static void
+bare_fs__data_ranges_work(uv_work_t *handle) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_data_ranges_t *job = req->job;
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  // Seeking moves the offset of the descriptor, which is shared with reads and
+  // writes at the current position that may be running meanwhile, so seek on a
+  // descriptor of our own. If the file can't be opened again, such as when it
+  // isn't readable, report the remainder of it as data.
+  int fd = bare_fs__reopen(job->fd);
+#else
+  int fd = -1;
+#endif
+
+  int64_t offset = job->offset, start, end;
+
+  uint32_t i = 0;
+
+  while (i < job->len) {
+    if (fd == -1) err = bare_fs__rest_data_range(handle->loop, job->fd, offset, &start, &end);
+    else err = bare_fs__next_data_range(handle->loop, fd, offset, &start, &end);
+
+    if (err < 0) break;
+
+    if (err == 1) {
+      err = 0;
+
+      break;
+    }
+
+    job->ranges[i * 2] = (double) start;
+    job->ranges[i * 2 + 1] = (double) (end - start);
+
+    offset = end;
+
+    i++;
+  }
+
+#if defined(SEEK_DATA) && defined(SEEK_HOLE)
+  if (fd != -1) close(fd);
+#endif
+
+  req->handle.result = err < 0 ? err : (int) i;
+}
+
+static inline js_value_t *
+bare_fs__data_ranges(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 4;
+  js_value_t *argv[4];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 4);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_data_ranges_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_data_ranges_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[2], &job->offset);
+  assert(err == 0);
+
+  size_t len;
+  err = js_get_typedarray_info(env, argv[3], NULL, (void **) &job->ranges, &len, NULL, NULL);
+  assert(err == 0);
+
+  job->len = (uint32_t) (len / 2);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__data_ranges_work, async);
+
+  int status;
+  err = bare_fs__request_pending(env, req, async, &status);
+  if (err != 1) return result;
+
+  err = js_create_int32(env, status, &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_data_ranges(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__data_ranges(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_data_ranges_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__data_ranges(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__read_lines_work(uv_work_t *handle) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_read_lines_t *job = req->job;
+
+  if (job->len < job->capacity) {
+    uv_buf_t buf = uv_buf_init((char *) job->data + job->len, (unsigned int) (job->capacity - job->len));
+
+    uv_fs_t fs;
+    err = uv_fs_read(handle->loop, &fs, job->fd, &buf, 1, job->pos, NULL);
+
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) {
+      req->handle.result = err;
+
+      return;
+    }
+
+    job->len += (size_t) err;
+  }
+
+  // The first element receives the number of bytes in the buffer, followed by
+  // the offsets of the newlines found in it.
+  job->lines[0] = (uint32_t) job->len;
+
+  uint8_t *next = job->data, *end = job->data + job->len;
+
+  uint32_t i = 0;
+
+  while (i < job->lines_len && next < end) {
+    uint8_t *newline = memchr(next, '\n', end - next);
+
+    if (newline == NULL) break;
+
+    job->lines[++i] = (uint32_t) (newline - job->data);
+
+    next = newline + 1;
+  }
+
+  req->handle.result = (int) i;
+}
+
+static inline js_value_t *
+bare_fs__read_lines(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 6;
+  js_value_t *argv[6];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 6);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_read_lines_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_read_lines_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[2], NULL, (void **) &job->data, &job->capacity, NULL, NULL);
+  assert(err == 0);
+
+  uint32_t len;
+  err = js_get_value_uint32(env, argv[3], &len);
+  assert(err == 0);
+
+  job->len = len;
+
+  err = js_get_value_int64(env, argv[4], &job->pos);
+  assert(err == 0);
+
+  size_t lines_len;
+  err = js_get_typedarray_info(env, argv[5], NULL, (void **) &job->lines, &lines_len, NULL, NULL);
+  assert(err == 0);
+
+  job->lines_len = (uint32_t) (lines_len - 1);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__read_lines_work, async);
+
+  int status;
+  err = bare_fs__request_pending(env, req, async, &status);
+  if (err != 1) return result;
+
+  err = js_create_int32(env, status, &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_read_lines(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__read_lines(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_read_lines_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__read_lines(env, info, bare_fs_sync);
+}
+
+// The maximum length of a string in UTF-16 code units, which is the limit of
+// V8 on 64-bit platforms and the lowest of the supported engines.
+#define BARE_FS_MAX_STRING_LENGTH ((1 << 29) - 24)
+
+static void
+bare_fs__read_utf8_work(uv_work_t *handle) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_read_utf8_t *job = req->job;
+
+  job->len = 0;
+
+  // As every UTF-16 code unit takes at least a byte, more bytes than the
+  // maximum string length are rejected before reading any of them.
+  if (job->size > BARE_FS_MAX_STRING_LENGTH) {
+    req->handle.result = UV_EFBIG;
+
+    return;
+  }
+
+  // Read up to the expected size if known, otherwise until the end of the
+  // file, growing the buffer as needed.
+  size_t capacity = job->size ? job->size : 8192;
+
+  job->data = malloc(capacity);
+
+  while (job->data != NULL) {
+    if (job->len == capacity) {
+      if (job->size) break;
+
+      if (capacity > BARE_FS_MAX_STRING_LENGTH) {
+        free(job->data);
+
+        job->data = NULL;
+
+        req->handle.result = UV_EFBIG;
+
+        return;
+      }
+
+      capacity *= 2;
+
+      char *data = realloc(job->data, capacity);
+
+      if (data == NULL) {
+        free(job->data);
+
+        job->data = NULL;
+
+        break;
+      }
+
+      job->data = data;
+    }
+
+    size_t len = capacity - job->len;
+
+    if (len > INT32_MAX) len = INT32_MAX;
+
+    uv_buf_t buf = uv_buf_init(job->data + job->len, (unsigned int) len);
+
+    uv_fs_t fs;
+    err = uv_fs_read(handle->loop, &fs, job->fd, &buf, 1, -1, NULL);
+
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) {
+      free(job->data);
+
+      job->data = NULL;
+
+      req->handle.result = err;
+
+      return;
+    }
+
+    if (err == 0) break;
+
+    job->len += (size_t) err;
+  }
+
+  req->handle.result = job->data == NULL ? UV_ENOMEM : 0;
+}
+
+static inline js_value_t *
+bare_fs__read_utf8(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 3;
+  js_value_t *argv[3];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 3);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_read_utf8_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_read_utf8_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  int64_t size;
+  err = js_get_value_int64(env, argv[2], &size);
+  assert(err == 0);
+
+  job->size = (size_t) size;
+  job->data = NULL;
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__read_utf8_work, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_read_utf8(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__read_utf8(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_read_utf8_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__read_utf8(env, info, bare_fs_sync);
+}
+
+// Returns the number of UTF-16 code units that the UTF-8 `data` decodes to,
+// which is one per code point, and two for those encoded in four bytes.
+static inline size_t
+bare_fs__utf16_length(const char *data, size_t len) {
+  size_t result = 0;
+
+  for (size_t i = 0; i < len; i++) {
+    uint8_t c = (uint8_t) data[i];
+
+    if ((c & 0xc0) != 0x80) result += c >= 0xf0 ? 2 : 1;
+  }
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_request_result_utf8(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 1;
+  js_value_t *argv[1];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 1);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  bare_fs_read_utf8_t *job = req->job;
+
+  // Creating a string beyond the limit of the engine would abort rather than
+  // throw, so reject it up front. Only decoding can tell whether contents
+  // that are longer in bytes still fit.
+  if (job->len > BARE_FS_MAX_STRING_LENGTH && bare_fs__utf16_length(job->data, job->len) > BARE_FS_MAX_STRING_LENGTH) {
+    free(job->data);
+
+    job->data = NULL;
+
+    err = js_throw_error(env, uv_err_name(UV_EFBIG), uv_strerror(UV_EFBIG));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  js_value_t *result;
+  err = js_create_string_utf8(env, (utf8_t *) job->data, job->len, &result);
+  assert(err == 0);
+
+  free(job->data);
+
+  job->data = NULL;
+
+  return result;
+}
+
+static void
+bare_fs__write_utf8_work(uv_work_t *handle) {
+  int err = 0;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_write_utf8_t *job = req->job;
+
+  size_t written = 0;
+
+  while (written < job->len) {
+    uv_buf_t buf = uv_buf_init(job->data + written, (unsigned int) (job->len - written));
+
+    uv_fs_t fs;
+    err = uv_fs_write(handle->loop, &fs, job->fd, &buf, 1, job->pos == -1 ? -1 : job->pos + (int64_t) written, NULL);
+
+    uv_fs_req_cleanup(&fs);
+
+    if (err <= 0) break;
+
+    written += (size_t) err;
+  }
+
+  free(job->data);
+
+  job->data = NULL;
+
+  req->handle.result = err < 0 ? err : (int) written;
+}
+
+static inline js_value_t *
+bare_fs__write_utf8(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 4;
+  js_value_t *argv[4];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 4);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_write_utf8_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_write_utf8_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[1], &job->fd);
+  assert(err == 0);
+
+  // Encode the string straight into native memory, which is released as soon
+  // as it has been written.
+  err = js_get_value_string_utf8(env, argv[2], NULL, 0, &job->len);
+  assert(err == 0);
+
+  // The number of bytes written is reported as a 32-bit integer.
+  if (job->len > INT32_MAX) {
+    err = js_throw_error(env, uv_err_name(UV_EFBIG), uv_strerror(UV_EFBIG));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  job->data = malloc(job->len ? job->len : 1);
+
+  if (job->data == NULL) {
+    err = js_throw_error(env, uv_err_name(UV_ENOMEM), uv_strerror(UV_ENOMEM));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  err = js_get_value_string_utf8(env, argv[2], (utf8_t *) job->data, job->len, NULL);
+  assert(err == 0);
+
+  err = js_get_value_int64(env, argv[3], &job->pos);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__write_utf8_work, async);
+
+  int status;
+  err = bare_fs__request_pending(env, req, async, &status);
+  if (err != 1) return result;
+
+  err = js_create_int32(env, status, &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_write_utf8(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__write_utf8(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_write_utf8_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__write_utf8(env, info, bare_fs_sync);
+}
+
+static int
+bare_fs__copy_range(uv_loop_t *loop, uv_file src, uv_file dst, int64_t start, int64_t end, uint8_t *data, size_t capacity) {
+  int err;
+
+  uv_fs_t fs;
+
+  while (start < end) {
+    size_t len = capacity;
+
+    if ((uint64_t) (end - start) < len) len = (size_t) (end - start);
+
+    uv_buf_t buf = uv_buf_init((void *) data, len);
+
+    err = uv_fs_read(loop, &fs, src, &buf, 1, start, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err < 0) return err;
+    if (err == 0) break;
+
+    buf.len = err;
+
+    while (buf.len > 0) {
+      err = uv_fs_write(loop, &fs, dst, &buf, 1, start, NULL);
+      uv_fs_req_cleanup(&fs);
+
+      if (err < 0) return err;
+
+      buf.base += err;
+      buf.len -= err;
+
+      start += err;
+    }
+  }
+
+  return 0;
+}
+
+static void
+bare_fs__copyfile_sparse_work(uv_work_t *handle) {
+  int err, res;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_copyfile_sparse_t *job = req->job;
+
+  uv_loop_t *loop = handle->loop;
+
+  uv_fs_t fs;
+
+  // A clone shares the extents of the source, holes included, so it's tried
+  // first when requested. Unless the clone is forced, copying falls back to
+  // the data ranges if it fails.
+  if (job->mode & (UV_FS_COPYFILE_FICLONE | UV_FS_COPYFILE_FICLONE_FORCE)) {
+    int flags = (job->mode & UV_FS_COPYFILE_EXCL) | UV_FS_COPYFILE_FICLONE_FORCE;
+
+    err = uv_fs_copyfile(loop, &fs, (char *) job->src, (char *) job->dst, flags, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err == 0 || (job->mode & UV_FS_COPYFILE_FICLONE_FORCE)) {
+      req->handle.result = err;
+
+      return;
+    }
+  }
+
+  err = uv_fs_open(loop, &fs, (char *) job->src, UV_FS_O_RDONLY, 0, NULL);
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) {
+    req->handle.result = err;
+
+    return;
+  }
+
+  uv_file src = err;
+
+  err = uv_fs_fstat(loop, &fs, src, NULL);
+
+  int64_t size = fs.statbuf.st_size;
+  int mode = fs.statbuf.st_mode & 0777;
+
+  uint64_t dev = fs.statbuf.st_dev;
+  uint64_t ino = fs.statbuf.st_ino;
+
+  uv_fs_req_cleanup(&fs);
+
+  uv_file dst = -1;
+
+  if (err < 0) goto done;
+
+  int flags = UV_FS_O_WRONLY | UV_FS_O_CREAT;
+
+  if (job->mode & UV_FS_COPYFILE_EXCL) flags |= UV_FS_O_EXCL;
+
+  // The destination is only truncated once it's known not to be the source,
+  // which would otherwise be lost.
+  err = uv_fs_open(loop, &fs, (char *) job->dst, flags, mode, NULL);
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) goto done;
+
+  dst = err;
+
+  err = uv_fs_fstat(loop, &fs, dst, NULL);
+
+  bool same = fs.statbuf.st_dev == dev && fs.statbuf.st_ino == ino;
+
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) goto done;
+
+  if (same) {
+    res = uv_fs_close(loop, &fs, dst, NULL);
+    (void) res;
+
+    uv_fs_req_cleanup(&fs);
+
+    dst = -1;
+
+    goto done;
+  }
+
+  // Like `uv_fs_copyfile()`, give an existing destination the mode of the
+  // source. Filesystems that don't support permissions refuse with `EPERM`.
+  err = uv_fs_fchmod(loop, &fs, dst, mode, NULL);
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0 && err != UV_EPERM) goto done;
+
+  // Truncating the destination and then extending it to the full size leaves
+  // it as a single hole, into which only the data ranges of the source are
+  // then written.
+  err = uv_fs_ftruncate(loop, &fs, dst, 0, NULL);
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) goto done;
+
+  err = uv_fs_ftruncate(loop, &fs, dst, size, NULL);
+  uv_fs_req_cleanup(&fs);
+
+  if (err < 0) goto done;
+
+  size_t capacity = 256 * 1024;
+
+  uint8_t *data = malloc(capacity);
+
+  if (data == NULL) {
+    err = UV_ENOMEM;
+
+    goto done;
+  }
+
+  int64_t offset = 0, start, end;
+
+  while (offset < size) {
+    err = bare_fs__next_data_range(loop, src, offset, &start, &end);
+
+    if (err != 0) break;
+
+    if (end > size) end = size;
+
+    err = bare_fs__copy_range(loop, src, dst, start, end, data, capacity);
+
+    if (err < 0) break;
+
+    offset = end;
+  }
+
+  free(data);
+
+  if (err == 1) err = 0;
+
+done:
+  if (dst != -1) {
+    res = uv_fs_close(loop, &fs, dst, NULL);
+    uv_fs_req_cleanup(&fs);
+
+    if (err == 0) err = res;
+
+    if (err < 0) {
+      res = uv_fs_unlink(loop, &fs, (char *) job->dst, NULL);
+      uv_fs_req_cleanup(&fs);
+    }
+  }
+
+  res = uv_fs_close(loop, &fs, src, NULL);
+  (void) res;
+
+  uv_fs_req_cleanup(&fs);
+
+  req->handle.result = err;
+}
+
+static inline js_value_t *
+bare_fs__copyfile_sparse(js_env_t *env, js_callback_info_t *info, bool async) {
+  int err;
+
+  size_t argc = 4;
+  js_value_t *argv[4];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 4);
+
+  bare_fs_req_t *req;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_copyfile_sparse_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_copyfile_sparse_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_string_utf8(env, argv[1], job->src, sizeof(bare_fs_path_t), NULL);
+  assert(err == 0);
+
+  err = js_get_value_string_utf8(env, argv[2], job->dst, sizeof(bare_fs_path_t), NULL);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[3], &job->mode);
+  assert(err == 0);
+
+  uv_loop_t *loop;
+  err = js_get_env_loop(env, &loop);
+  assert(err == 0);
+
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__copyfile_sparse_work, async);
+
+  err = bare_fs__request_pending(env, req, async, NULL);
+  (void) err;
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_copyfile_sparse(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__copyfile_sparse(env, info, bare_fs_async);
+}
+
+static js_value_t *
+bare_fs_copyfile_sparse_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__copyfile_sparse(env, info, bare_fs_sync);
+}
+
+static void
+bare_fs__on_disk_usage_links_finalize(js_env_t *env, void *data, void *finalize_hint) {
+  bare_fs_disk_usage_links_t *links = data;
+
+  uv_mutex_destroy(&links->lock);
+
+  free(links->inodes);
+  free(links);
+}
+
+static js_value_t *
+bare_fs_disk_usage_links(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  bare_fs_disk_usage_links_t *links = malloc(sizeof(bare_fs_disk_usage_links_t));
+
+  if (links == NULL) {
+    err = js_throw_error(env, uv_err_name(UV_ENOMEM), uv_strerror(UV_ENOMEM));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  err = uv_mutex_init(&links->lock);
+  assert(err == 0);
+
+  links->inodes = NULL;
+  links->len = 0;
+  links->capacity = 0;
+
+  js_value_t *result;
+  err = js_create_external_arraybuffer(env, links, sizeof(bare_fs_disk_usage_links_t), bare_fs__on_disk_usage_links_finalize, NULL, &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static inline size_t
+bare_fs__disk_usage_hash(uint64_t dev, uint64_t ino) {
+  uint64_t h = ino * 0x9e3779b97f4a7c15ULL ^ dev;
+
+  h ^= h >> 31;
+  h *= 0xbf58476d1ce4e5b9ULL;
+  h ^= h >> 29;
+
+  return (size_t) h;
+}
+
+static inline bare_fs_disk_usage_inode_t *
+bare_fs__disk_usage_slot(bare_fs_disk_usage_inode_t *inodes, size_t capacity, uint64_t dev, uint64_t ino) {
+  size_t i = bare_fs__disk_usage_hash(dev, ino) & (capacity - 1);
+
+  while (inodes[i].used && (inodes[i].dev != dev || inodes[i].ino != ino)) {
+    i = (i + 1) & (capacity - 1);
+  }
+
+  return &inodes[i];
+}
+
+// Returns 1 if the inode was seen before, 0 if not, or a negative error code.
+static int
+bare_fs__disk_usage_link(bare_fs_disk_usage_links_t *links, uint64_t dev, uint64_t ino) {
+  int err = 0;
+
+  uv_mutex_lock(&links->lock);
+
+  if (links->len * 2 >= links->capacity) {
+    size_t capacity = links->capacity ? links->capacity * 2 : 256;
+
+    bare_fs_disk_usage_inode_t *inodes = calloc(capacity, sizeof(bare_fs_disk_usage_inode_t));
+
+    if (inodes == NULL) {
+      err = UV_ENOMEM;
+
+      goto done;
+    }
+
+    for (size_t i = 0; i < links->capacity; i++) {
+      bare_fs_disk_usage_inode_t *inode = &links->inodes[i];
+
+      if (inode->used) *bare_fs__disk_usage_slot(inodes, capacity, inode->dev, inode->ino) = *inode;
+    }
+
+    free(links->inodes);
+
+    links->inodes = inodes;
+    links->capacity = capacity;
+  }
+
+  bare_fs_disk_usage_inode_t *inode = bare_fs__disk_usage_slot(links->inodes, links->capacity, dev, ino);
+
+  if (inode->used) err = 1;
+  else {
+    inode->dev = dev;
+    inode->ino = ino;
+    inode->used = true;
+
+    links->len++;
+  }
+
+done:
+  uv_mutex_unlock(&links->lock);
+
+  return err;
+}
+
+static int
+bare_fs__disk_usage_add(bare_fs_disk_usage_t *job, uint64_t dev, uint64_t ino, uint64_t nlink, uint64_t size, uint64_t blocks, bool directory) {
+  if (job->links && nlink > 1 && !directory) {
+    int err = bare_fs__disk_usage_link(job->links, dev, ino);
+
+    if (err != 0) return err < 0 ? err : 0;
+  }
+
+#ifdef _WIN32
+  // Block counts aren't available on Windows, so always use the apparent size.
+  job->result[0] += (double) size;
+#else
+  job->result[0] += (double) (job->apparent ? size : blocks * 512);
+#endif
+  job->result[1] += (double) blocks;
+  job->result[2] += 1;
+
+  return 0;
+}
+
+#ifdef _WIN32
+
+static int
+bare_fs__disk_usage_walk(uv_loop_t *loop, bare_fs_disk_usage_t *job, size_t len, int32_t depth) {
+  int err;
+
+  uv_fs_t fs;
+  err = uv_fs_lstat(loop, &fs, (char *) job->path, NULL);
+
+  if (err < 0) {
+    uv_fs_req_cleanup(&fs);
+
+    // Entries removed while walking are skipped.
+    return err == UV_ENOENT ? 0 : err;
+  }
+
+  uv_stat_t st = fs.statbuf;
+
+  uv_fs_req_cleanup(&fs);
+
+  bool directory = (st.st_mode & S_IFMT) == S_IFDIR;
+
+  if (depth > 0 || job->self) {
+    err = bare_fs__disk_usage_add(job, st.st_dev, st.st_ino, st.st_nlink, st.st_size, st.st_blocks, directory);
+    if (err < 0) return err;
+  }
+
+  if (!directory || (job->max_depth >= 0 && depth >= job->max_depth)) return 0;
+
+  err = uv_fs_scandir(loop, &fs, (char *) job->path, 0, NULL);
+
+  if (err < 0) {
+    uv_fs_req_cleanup(&fs);
+
+    return err == UV_ENOENT ? 0 : err;
+  }
+
+  uv_dirent_t entry;
+
+  while ((err = uv_fs_scandir_next(&fs, &entry)) != UV_EOF) {
+    size_t name_len = strlen(entry.name);
+
+    if (len + 1 + name_len >= sizeof(bare_fs_path_t)) {
+      err = UV_ENAMETOOLONG;
+
+      break;
+    }
+
+    job->path[len] = '\\';
+
+    memcpy(&job->path[len + 1], entry.name, name_len + 1);
+
+    err = bare_fs__disk_usage_walk(loop, job, len + 1 + name_len, depth + 1);
+    if (err < 0) break;
+  }
+
+  job->path[len] = '\0';
+
+  uv_fs_req_cleanup(&fs);
+
+  return err == UV_EOF ? 0 : err;
+}
 
-static js_value_t *
-bare_fs_closedir_sync(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__closedir(env, info, bare_fs_sync);
+#else
+
+// Walks the entries of the directory at `job->path`, which is `len` bytes long.
+// The names of subdirectories are collected and the directory closed before
+// descending into them, so only a single directory is open at a time no matter
+// how deep the tree is.
+static int
+bare_fs__disk_usage_walk_dir(bare_fs_disk_usage_t *job, size_t len, int32_t depth) {
+  int err = 0;
+
+  int fd = open((char *) job->path, O_RDONLY | O_DIRECTORY | O_NOFOLLOW | O_CLOEXEC);
+
+  // Entries removed while walking are skipped.
+  if (fd == -1) return errno == ENOENT ? 0 : uv_translate_sys_error(errno);
+
+  DIR *dir = fdopendir(fd);
+
+  if (dir == NULL) {
+    err = uv_translate_sys_error(errno);
+
+    close(fd);
+
+    return err;
+  }
+
+  bool descend = job->max_depth < 0 || depth < job->max_depth;
+
+  // NULL-terminated names of the subdirectories to descend into, one after the
+  // other.
+  char *names = NULL;
+  size_t names_len = 0;
+  size_t names_capacity = 0;
+
+  struct dirent *entry;
+
+  while (errno = 0, (entry = readdir(dir)) != NULL) {
+    const char *name = entry->d_name;
+
+    if (name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) continue;
+
+    struct stat st;
+
+    if (fstatat(fd, name, &st, AT_SYMLINK_NOFOLLOW) == -1) {
+      if (errno == ENOENT) continue;
+
+      err = uv_translate_sys_error(errno);
+
+      break;
+    }
+
+    bool directory = S_ISDIR(st.st_mode);
+
+    err = bare_fs__disk_usage_add(job, st.st_dev, st.st_ino, st.st_nlink, st.st_size, st.st_blocks, directory);
+    if (err < 0) break;
+
+    if (!directory || !descend) continue;
+
+    size_t name_len = strlen(name) + 1;
+
+    if (names_len + name_len > names_capacity) {
+      size_t capacity = names_capacity == 0 ? 256 : names_capacity;
+
+      while (capacity < names_len + name_len) capacity *= 2;
+
+      char *grown = realloc(names, capacity);
+
+      if (grown == NULL) {
+        err = UV_ENOMEM;
+
+        break;
+      }
+
+      names = grown;
+      names_capacity = capacity;
+    }
+
+    memcpy(&names[names_len], name, name_len);
+
+    names_len += name_len;
+  }
+
+  if (err == 0 && errno != 0) err = uv_translate_sys_error(errno);
+
+  closedir(dir);
+
+  for (size_t i = 0; err == 0 && i < names_len;) {
+    const char *name = &names[i];
+
+    size_t name_len = strlen(name);
+
+    i += name_len + 1;
+
+    if (len + 1 + name_len >= sizeof(bare_fs_path_t)) {
+      err = UV_ENAMETOOLONG;
+
+      break;
+    }
+
+    job->path[len] = '/';
+
+    memcpy(&job->path[len + 1], name, name_len + 1);
+
+    err = bare_fs__disk_usage_walk_dir(job, len + 1 + name_len, depth + 1);
+  }
+
+  job->path[len] = '\0';
+
+  free(names);
+
+  return err;
 }
 
+static int
+bare_fs__disk_usage_walk(uv_loop_t *loop, bare_fs_disk_usage_t *job, size_t len, int32_t depth) {
+  struct stat st;
+
+  // Entries removed while walking are skipped.
+  if (lstat((char *) job->path, &st) == -1) return errno == ENOENT ? 0 : uv_translate_sys_error(errno);
+
+  bool directory = S_ISDIR(st.st_mode);
+
+  if (job->self) {
+    int err = bare_fs__disk_usage_add(job, st.st_dev, st.st_ino, st.st_nlink, st.st_size, st.st_blocks, directory);
+    if (err < 0) return err;
+  }
+
+  if (!directory || (job->max_depth >= 0 && depth >= job->max_depth)) return 0;
+
+  return bare_fs__disk_usage_walk_dir(job, len, depth + 1);
+}
+
+#endif
+
 static void
-bare_fs__on_fsync(uv_fs_t *handle) {
-  bare_fs__on_request_result(handle);
+bare_fs__disk_usage_work(uv_work_t *handle) {
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_disk_usage_t *job = req->job;
+
+  job->result[0] = job->result[1] = job->result[2] = 0;
+
+  req->handle.result = bare_fs__disk_usage_walk(handle->loop, job, strlen((char *) job->path), 0);
 }
 
 static inline js_value_t *
-bare_fs__fsync(js_env_t *env, js_callback_info_t *info, bool async) {
+bare_fs__disk_usage(js_env_t *env, js_callback_info_t *info, bool async) {
   int err;
 
-  size_t argc = 2;
-  js_value_t *argv[2];
+  size_t argc = 7;
+  js_value_t *argv[7];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 2);
+  assert(argc == 7);
 
   bare_fs_req_t *req;
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
   assert(err == 0);
 
-  uint32_t fd;
-  err = js_get_value_uint32(env, argv[1], &fd);
+  js_value_t *result;
+
+  bare_fs_disk_usage_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_disk_usage_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_value_string_utf8(env, argv[1], job->path, sizeof(bare_fs_path_t), NULL);
+  assert(err == 0);
+
+  err = js_get_value_bool(env, argv[2], &job->apparent);
+  assert(err == 0);
+
+  err = js_get_value_int32(env, argv[3], &job->max_depth);
+  assert(err == 0);
+
+  err = js_get_value_bool(env, argv[4], &job->self);
+  assert(err == 0);
+
+  bool is_null;
+  err = js_is_null(env, argv[5], &is_null);
+  assert(err == 0);
+
+  if (is_null) job->links = NULL;
+  else {
+    err = js_get_arraybuffer_info(env, argv[5], (void **) &job->links, NULL);
+    assert(err == 0);
+  }
+
+  err = js_get_typedarray_info(env, argv[6], NULL, (void **) &job->result, NULL, NULL, NULL);
   assert(err == 0);
 
   uv_loop_t *loop;
   err = js_get_env_loop(env, &loop);
   assert(err == 0);
 
-  err = uv_fs_fsync(loop, &req->handle, fd, async ? bare_fs__on_fsync : NULL);
-  (void) err;
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__disk_usage_work, async);
 
   err = bare_fs__request_pending(env, req, async, NULL);
   (void) err;
 
-  return NULL;
+  return result;
 }
 
 static js_value_t *
-bare_fs_fsync(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__fsync(env, info, bare_fs_async);
+bare_fs_disk_usage(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__disk_usage(env, info, bare_fs_async);
 }
 
 static js_value_t *
-bare_fs_fsync_sync(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__fsync(env, info, bare_fs_sync);
+bare_fs_disk_usage_sync(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__disk_usage(env, info, bare_fs_sync);
 }
 
 static void
-bare_fs__on_fdatasync(uv_fs_t *handle) {
-  bare_fs__on_request_result(handle);
+bare_fs__stat_sweep_work(uv_work_t *handle) {
+  int err;
+
+  bare_fs_req_t *req = (bare_fs_req_t *) handle->data;
+
+  bare_fs_stat_sweep_t *job = req->job;
+
+  const utf8_t *path = job->paths;
+
+  uint32_t changed = 0;
+
+  for (uint32_t i = 0; i < job->len; i++) {
+    const double *prev = &job->prev[i * BARE_FS_STAT_FIELDS];
+    double *next = &job->next[i * BARE_FS_STAT_FIELDS];
+
+    uv_fs_t fs;
+    err = uv_fs_stat(handle->loop, &fs, (const char *) path, NULL);
+
+    // Files that can't be stat'ed, such as missing files, report all zeros.
+    if (err < 0) memset(next, 0, BARE_FS_STAT_FIELDS * sizeof(double));
+    else bare_fs__stat_fields(&fs.statbuf, next);
+
+    uv_fs_req_cleanup(&fs);
+
+    // Compare the inode, size, mtime, and ctime.
+    if (prev[7] != next[7] || prev[8] != next[8] || prev[11] != next[11] || prev[12] != next[12]) {
+      job->changed[changed++] = i;
+    }
+
+    path += strlen((const char *) path) + 1;
+  }
+
+  req->handle.result = (int) changed;
 }
 
 static inline js_value_t *
-bare_fs__fdatasync(js_env_t *env, js_callback_info_t *info, bool async) {
+bare_fs__stat_sweep(js_env_t *env, js_callback_info_t *info, bool async) {
   int err;
 
-  size_t argc = 2;
-  js_value_t *argv[2];
+  size_t argc = 6;
+  js_value_t *argv[6];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 2);
+  assert(argc == 6);
 
   bare_fs_req_t *req;
   err = js_get_arraybuffer_info(env, argv[0], (void **) &req, NULL);
   assert(err == 0);
 
-  uint32_t fd;
-  err = js_get_value_uint32(env, argv[1], &fd);
+  js_value_t *result;
+
+  bare_fs_stat_sweep_t *job;
+  err = js_create_arraybuffer(env, sizeof(bare_fs_stat_sweep_t), (void **) &job, &result);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[1], NULL, (void **) &job->paths, NULL, NULL, NULL);
+  assert(err == 0);
+
+  err = js_get_value_uint32(env, argv[2], &job->len);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[3], NULL, (void **) &job->prev, NULL, NULL, NULL);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[4], NULL, (void **) &job->next, NULL, NULL, NULL);
+  assert(err == 0);
+
+  err = js_get_typedarray_info(env, argv[5], NULL, (void **) &job->changed, NULL, NULL, NULL);
   assert(err == 0);
 
   uv_loop_t *loop;
   err = js_get_env_loop(env, &loop);
   assert(err == 0);
 
-  err = uv_fs_fdatasync(loop, &req->handle, fd, async ? bare_fs__on_fdatasync : NULL);
-  (void) err;
+  req->job = job;
+
+  bare_fs__request_work(loop, req, bare_fs__stat_sweep_work, async);
 
   err = bare_fs__request_pending(env, req, async, NULL);
   (void) err;
 
-  return NULL;
-}
-
-static js_value_t *
-bare_fs_fdatasync(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__fdatasync(env, info, bare_fs_async);
+  return result;
 }
 
 static js_value_t *
-bare_fs_fdatasync_sync(js_env_t *env, js_callback_info_t *info) {
-  return bare_fs__fdatasync(env, info, bare_fs_sync);
+bare_fs_stat_sweep(js_env_t *env, js_callback_info_t *info) {
+  return bare_fs__stat_sweep(env, info, bare_fs_async);
 }
 
 static void
@@ -2491,11 +5093,16 @@ bare_fs__on_watcher_event(uv_fs_event_t *handle, const char *filename, int event
 
     size_t len = strlen(filename);
 
-    void *data;
-    err = js_create_arraybuffer(env, len, &data, &args[2]);
-    assert(err == 0);
+    if (watcher->utf8) {
+      err = js_create_string_utf8(env, (utf8_t *) filename, len, &args[2]);
+      assert(err == 0);
+    } else {
+      void *data;
+      err = js_create_arraybuffer(env, len, &data, &args[2]);
+      assert(err == 0);
 
-    memcpy(data, (void *) filename, len);
+      memcpy(data, (void *) filename, len);
+    }
   }
 
   err = js_call_function(env, ctx, on_event, 3, args, NULL);
@@ -2572,13 +5179,13 @@ static js_value_t *
 bare_fs_watcher_init(js_env_t *env, js_callback_info_t *info) {
   int err;
 
-  size_t argc = 5;
-  js_value_t *argv[5];
+  size_t argc = 6;
+  js_value_t *argv[6];
 
   err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
   assert(err == 0);
 
-  assert(argc == 5);
+  assert(argc == 6);
 
   bare_fs_path_t path;
   err = js_get_value_string_utf8(env, argv[0], path, sizeof(bare_fs_path_t), NULL);
@@ -2588,6 +5195,10 @@ bare_fs_watcher_init(js_env_t *env, js_callback_info_t *info) {
   err = js_get_value_bool(env, argv[1], &recursive);
   assert(err == 0);
 
+  bool utf8;
+  err = js_get_value_bool(env, argv[2], &utf8);
+  assert(err == 0);
+
   js_value_t *result;
 
   bare_fs_watcher_t *watcher;
@@ -2613,14 +5224,15 @@ bare_fs_watcher_init(js_env_t *env, js_callback_info_t *info) {
   watcher->env = env;
   watcher->closing = false;
   watcher->exiting = false;
+  watcher->utf8 = utf8;
 
-  err = js_create_reference(env, argv[2], 1, &watcher->ctx);
+  err = js_create_reference(env, argv[3], 1, &watcher->ctx);
   assert(err == 0);
 
-  err = js_create_reference(env, argv[3], 1, &watcher->on_event);
+  err = js_create_reference(env, argv[4], 1, &watcher->on_event);
   assert(err == 0);
 
-  err = js_create_reference(env, argv[4], 1, &watcher->on_close);
+  err = js_create_reference(env, argv[5], 1, &watcher->on_close);
   assert(err == 0);
 
   err = js_add_deferred_teardown_callback(env, bare_fs__on_watcher_teardown, (void *) watcher, &watcher->teardown);
@@ -2697,6 +5309,144 @@ bare_fs_watcher_unref(js_env_t *env, js_callback_info_t *info) {
   return NULL;
 }
 
+static void
+bare_fs__on_aligned_finalize(js_env_t *env, void *data, void *finalize_hint) {
+#ifdef _WIN32
+  _aligned_free(data);
+#else
+  free(data);
+#endif
+}
+
+static js_value_t *
+bare_fs_alloc_aligned(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  int64_t len;
+  err = js_get_value_int64(env, argv[0], &len);
+  assert(err == 0);
+
+  uint32_t alignment;
+  err = js_get_value_uint32(env, argv[1], &alignment);
+  assert(err == 0);
+
+  // Zero sized allocations may return NULL, so always allocate at least one
+  // byte to keep the buffer distinct.
+  size_t size = len > 0 ? (size_t) len : 1;
+
+  void *data;
+
+#ifdef _WIN32
+  data = _aligned_malloc(size, alignment);
+
+  if (data == NULL) err = UV_ENOMEM;
+#else
+  err = posix_memalign(&data, alignment, size);
+
+  if (err != 0) err = uv_translate_sys_error(err);
+#endif
+
+  if (err < 0) {
+    err = js_throw_error(env, uv_err_name(err), uv_strerror(err));
+    assert(err == 0);
+
+    return NULL;
+  }
+
+  js_value_t *result;
+  err = js_create_external_arraybuffer(env, data, len > 0 ? (size_t) len : 0, bare_fs__on_aligned_finalize, NULL, &result);
+  assert(err == 0);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_compile_glob(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 2;
+  js_value_t *argv[2];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 2);
+
+  uint8_t *source;
+  size_t len;
+  err = js_get_typedarray_info(env, argv[0], NULL, (void **) &source, &len, NULL, NULL);
+  assert(err == 0);
+
+  bool dot;
+  err = js_get_value_bool(env, argv[1], &dot);
+  assert(err == 0);
+
+  js_value_t *result;
+
+  bare_fs_glob_t *glob;
+  err = js_create_arraybuffer(env, bare_fs_glob_size(source, len), (void **) &glob, &result);
+  assert(err == 0);
+
+  bare_fs_glob_compile(glob, source, len, dot);
+
+  return result;
+}
+
+static js_value_t *
+bare_fs_step_glob(js_env_t *env, js_callback_info_t *info) {
+  int err;
+
+  size_t argc = 5;
+  js_value_t *argv[5];
+
+  err = js_get_callback_info(env, info, &argc, argv, NULL, NULL);
+  assert(err == 0);
+
+  assert(argc == 5);
+
+  bare_fs_glob_t *glob;
+  err = js_get_arraybuffer_info(env, argv[0], (void **) &glob, NULL);
+  assert(err == 0);
+
+  uint32_t *states;
+  size_t len;
+  err = js_get_typedarray_info(env, argv[1], NULL, (void **) &states, &len, NULL, NULL);
+  assert(err == 0);
+
+  uint8_t *name;
+  size_t name_len;
+  err = js_get_typedarray_info(env, argv[2], NULL, (void **) &name, &name_len, NULL, NULL);
+  assert(err == 0);
+
+  bool directory;
+  err = js_get_value_bool(env, argv[3], &directory);
+  assert(err == 0);
+
+  uint32_t *next;
+  err = js_get_typedarray_info(env, argv[4], NULL, (void **) &next, NULL, NULL, NULL);
+  assert(err == 0);
+
+  // The first element receives the match flags, followed by the next states.
+  int flags;
+  uint32_t next_len = bare_fs_glob_step(glob, states, (uint32_t) len, name, name_len, directory, &next[1], &flags);
+
+  next[0] = (uint32_t) flags;
+
+  js_value_t *result;
+  err = js_create_uint32(env, next_len, &result);
+  assert(err == 0);
+
+  return result;
+}
+
 static js_value_t *
 bare_fs_exports(js_env_t *env, js_value_t *exports) {
   int err;
@@ -2713,12 +5463,17 @@ bare_fs_exports(js_env_t *env, js_value_t *exports) {
   V("requestInit", bare_fs_request_init)
   V("requestDestroy", bare_fs_request_destroy)
   V("requestReset", bare_fs_request_reset)
+  V("requestProbe", bare_fs_request_probe)
   V("requestResultStat", bare_fs_request_result_stat)
   V("requestResultStatfs", bare_fs_request_result_statfs)
   V("requestResultString", bare_fs_request_result_string)
+  V("requestResultStringUtf8", bare_fs_request_result_string_utf8)
+  V("requestResultUtf8", bare_fs_request_result_utf8)
   V("requestResultPath", bare_fs_request_result_path)
+  V("requestResultDigest", bare_fs_request_result_digest)
   V("requestResultDir", bare_fs_request_result_dir)
   V("requestResultDirents", bare_fs_request_result_dirents)
+  V("requestResultStatus", bare_fs_request_result_status)
 
   V("open", bare_fs_open)
   V("openSync", bare_fs_open_sync)
@@ -2734,6 +5489,10 @@ bare_fs_exports(js_env_t *env, js_value_t *exports) {
   V("writeSync", bare_fs_write_sync)
   V("writev", bare_fs_writev)
   V("writevSync", bare_fs_writev_sync)
+  V("readMany", bare_fs_read_many)
+  V("readManySync", bare_fs_read_many_sync)
+  V("writeMany", bare_fs_write_many)
+  V("writeManySync", bare_fs_write_many_sync)
   V("ftruncate", bare_fs_ftruncate)
   V("ftruncateSync", bare_fs_ftruncate_sync)
   V("chmod", bare_fs_chmod)
@@ -2784,17 +5543,45 @@ bare_fs_exports(js_env_t *env, js_value_t *exports) {
   V("opendirSync", bare_fs_opendir_sync)
   V("readdir", bare_fs_readdir)
   V("readdirSync", bare_fs_readdir_sync)
+  V("readdirStats", bare_fs_readdir_stats)
+  V("readdirStatsSync", bare_fs_readdir_stats_sync)
   V("closedir", bare_fs_closedir)
   V("closedirSync", bare_fs_closedir_sync)
   V("fsync", bare_fs_fsync)
   V("fsyncSync", bare_fs_fsync_sync)
   V("fdatasync", bare_fs_fdatasync)
   V("fdatasyncSync", bare_fs_fdatasync_sync)
+  V("hashFile", bare_fs_hash_file)
+  V("hashFileSync", bare_fs_hash_file_sync)
+  V("hash", bare_fs_hash)
+  V("fallocate", bare_fs_fallocate)
+  V("fallocateSync", bare_fs_fallocate_sync)
+  V("writeback", bare_fs_writeback)
+  V("writebackSync", bare_fs_writeback_sync)
+  V("dataRanges", bare_fs_data_ranges)
+  V("dataRangesSync", bare_fs_data_ranges_sync)
+  V("readLines", bare_fs_read_lines)
+  V("readLinesSync", bare_fs_read_lines_sync)
+  V("readUtf8", bare_fs_read_utf8)
+  V("readUtf8Sync", bare_fs_read_utf8_sync)
+  V("writeUtf8", bare_fs_write_utf8)
+  V("writeUtf8Sync", bare_fs_write_utf8_sync)
+  V("copyfileSparse", bare_fs_copyfile_sparse)
+  V("copyfileSparseSync", bare_fs_copyfile_sparse_sync)
+  V("diskUsage", bare_fs_disk_usage)
+  V("diskUsageSync", bare_fs_disk_usage_sync)
+  V("diskUsageLinks", bare_fs_disk_usage_links)
+  V("statSweep", bare_fs_stat_sweep)
 
   V("watcherInit", bare_fs_watcher_init)
   V("watcherClose", bare_fs_watcher_close)
   V("watcherRef", bare_fs_watcher_ref)
   V("watcherUnref", bare_fs_watcher_unref)
+
+  V("allocAligned", bare_fs_alloc_aligned)
+
+  V("compileGlob", bare_fs_compile_glob)
+  V("stepGlob", bare_fs_step_glob)
 #undef V
 
 #define V(name) \
@@ -2884,10 +5671,35 @@ bare_fs_exports(js_env_t *env, js_value_t *exports) {
   V(UV_FS_SYMLINK_DIR)
   V(UV_FS_SYMLINK_JUNCTION)
 
+  V(UV_FS_O_DIRECT)
+
   V(UV_RENAME)
   V(UV_CHANGE)
 #undef V
 
+#define V(name, value) \
+  { \
+    js_value_t *val; \
+    err = js_create_uint32(env, value, &val); \
+    assert(err == 0); \
+    err = js_set_named_property(env, exports, name, val); \
+    assert(err == 0); \
+  }
+
+  V("HASH_SHA256", bare_fs_hash_sha256)
+  V("HASH_BLAKE2B512", bare_fs_hash_blake2b512)
+  V("HASH_CRC32C", bare_fs_hash_crc32c)
+  V("FALLOCATE_KEEP_SIZE", bare_fs_fallocate_keep_size)
+  V("FALLOCATE_PUNCH_HOLE", bare_fs_fallocate_punch_hole)
+  V("FALLOCATE_ZERO_RANGE", bare_fs_fallocate_zero_range)
+  V("FALLOCATE_COLLAPSE_RANGE", bare_fs_fallocate_collapse_range)
+  V("WRITEBACK_WAIT", bare_fs_writeback_wait)
+  V("WRITEBACK_DROP", bare_fs_writeback_drop)
+  V("GLOB_MATCH", bare_fs_glob_match)
+  V("GLOB_MATCH_ALL", bare_fs_glob_match_all)
+  V("SIZEOF_DIRENT", sizeof(bare_fs_dirent_t))
+#undef V
+
   js_value_t *errnos;
   err = js_create_object(env, &errnos);
   assert(err == 0);
@@ -0,0 +1,290 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "glob.h"
+
+static inline bool
+bare_fs__glob_skip_segment(const uint8_t *segment, size_t len) {
+  return len == 0 || (len == 1 && segment[0] == '.');
+}
+
+static inline int
+bare_fs__glob_segment_kind(const uint8_t *segment, size_t len) {
+  if (len == 2 && segment[0] == '*' && segment[1] == '*') return bare_fs_glob_globstar;
+
+  for (size_t i = 0; i < len; i++) {
+    switch (segment[i]) {
+    case '*':
+    case '?':
+    case '[':
+    case '\\':
+      return bare_fs_glob_wildcard;
+    }
+  }
+
+  return bare_fs_glob_literal;
+}
+
+size_t
+bare_fs_glob_size(const uint8_t *source, size_t len) {
+  size_t segments = 0;
+
+  for (size_t i = 0, start = 0; i <= len; i++) {
+    if (i < len && source[i] != '/' && source[i] != '\0') continue;
+
+    if (!bare_fs__glob_skip_segment(&source[start], i - start)) segments++;
+
+    start = i + 1;
+  }
+
+  return sizeof(bare_fs_glob_t) + segments * sizeof(bare_fs_glob_segment_t) + len;
+}
+
+void
+bare_fs_glob_compile(bare_fs_glob_t *glob, const uint8_t *source, size_t len, bool dot) {
+  glob->dot = dot;
+  glob->len = 0;
+
+  uint32_t pattern = 0;
+
+  for (size_t i = 0, start = 0; i <= len; i++) {
+    if (i < len && source[i] != '/' && source[i] != '\0') continue;
+
+    if (!bare_fs__glob_skip_segment(&source[start], i - start)) {
+      bare_fs_glob_segment_t *segment = &glob->segments[glob->len++];
+
+      segment->offset = (uint32_t) start;
+      segment->len = (uint32_t) (i - start);
+      segment->kind = bare_fs__glob_segment_kind(&source[start], i - start);
+    }
+
+    // At the end of a pattern, point its segments past it.
+    if (i == len || source[i] == '\0') {
+      for (uint32_t j = pattern; j < glob->len; j++) glob->segments[j].end = glob->len;
+
+      pattern = glob->len;
+    }
+
+    start = i + 1;
+  }
+
+  memcpy(&glob->segments[glob->len], source, len);
+}
+
+static inline const uint8_t *
+bare_fs__glob_source(const bare_fs_glob_t *glob) {
+  return (const uint8_t *) &glob->segments[glob->len];
+}
+
+// Decodes a single UTF-8 character, treating invalid bytes as characters of
+// their own.
+static inline uint32_t
+bare_fs__glob_decode(const uint8_t **p, const uint8_t *end) {
+  const uint8_t *s = *p;
+
+  uint32_t c = *s++;
+
+  size_t n = c >= 0xf0 ? 3 : c >= 0xe0 ? 2 : c >= 0xc0 ? 1 : 0;
+
+  if ((size_t) (end - s) < n) n = 0;
+
+  if (n) c &= 0x3f >> n;
+
+  for (size_t i = 0; i < n; i++) {
+    if ((s[i] & 0xc0) != 0x80) {
+      *p = s;
+
+      return s[-1];
+    }
+
+    c = c << 6 | (s[i] & 0x3f);
+  }
+
+  *p = s + n;
+
+  return c;
+}
+
+// Matches a bracket expression starting at `*p`, which is advanced past it.
+// Returns -1 if the expression isn't terminated, in which case the bracket is
+// matched literally.
+static inline int
+bare_fs__glob_match_class(const uint8_t **p, const uint8_t *end, uint32_t c) {
+  const uint8_t *s = *p + 1;
+
+  bool negate = s < end && (*s == '!' || *s == '^');
+
+  if (negate) s++;
+
+  bool matched = false;
+  bool first = true;
+
+  while (s < end && (*s != ']' || first)) {
+    first = false;
+
+    if (*s == '\\' && s + 1 < end) s++;
+
+    uint32_t lo = bare_fs__glob_decode(&s, end), hi = lo;
+
+    if (s + 1 < end && *s == '-' && s[1] != ']') {
+      s++;
+
+      if (*s == '\\' && s + 1 < end) s++;
+
+      hi = bare_fs__glob_decode(&s, end);
+    }
+
+    if (c >= lo && c <= hi) matched = true;
+  }
+
+  if (s == end) return -1;
+
+  *p = s + 1;
+
+  return matched != negate;
+}
+
+static bool
+bare_fs__glob_match_wildcard(const uint8_t *p, const uint8_t *pe, const uint8_t *n, const uint8_t *ne) {
+  const uint8_t *star_p = NULL, *star_n = NULL;
+
+  while (n < ne) {
+    if (p < pe) {
+      if (*p == '*') {
+        star_p = ++p;
+        star_n = n;
+
+        continue;
+      }
+
+      if (*p == '?') {
+        p++;
+
+        bare_fs__glob_decode(&n, ne);
+
+        continue;
+      }
+
+      if (*p == '[') {
+        const uint8_t *q = p, *m = n;
+
+        int matched = bare_fs__glob_match_class(&q, pe, bare_fs__glob_decode(&m, ne));
+
+        if (matched == 1) {
+          p = q;
+          n = m;
+
+          continue;
+        }
+
+        if (matched == 0) goto backtrack;
+      }
+
+      const uint8_t *c = p;
+
+      if (*c == '\\' && c + 1 < pe) c++;
+
+      if (*c == *n) {
+        p = c + 1;
+        n++;
+
+        continue;
+      }
+    }
+
+  backtrack:
+    if (star_p == NULL) return false;
+
+    // Let the last star consume one more character and retry.
+    bare_fs__glob_decode(&star_n, ne);
+
+    p = star_p;
+    n = star_n;
+  }
+
+  while (p < pe && *p == '*') p++;
+
+  return p == pe;
+}
+
+static inline bool
+bare_fs__glob_match_segment(const bare_fs_glob_t *glob, const bare_fs_glob_segment_t *segment, const uint8_t *name, size_t name_len, bool hidden) {
+  const uint8_t *source = bare_fs__glob_source(glob) + segment->offset;
+
+  if (segment->kind == bare_fs_glob_literal) {
+    return segment->len == name_len && memcmp(source, name, name_len) == 0;
+  }
+
+  // Hidden entries are only matched by wildcards that start with a dot.
+  if (hidden && source[0] != '.') return false;
+
+  return bare_fs__glob_match_wildcard(source, source + segment->len, name, name + name_len);
+}
+
+// Whether the segments from `i` up to `end` only consist of globstars, and so
+// match any remaining path, including an empty one.
+static inline bool
+bare_fs__glob_rest_is_globstar(const bare_fs_glob_t *glob, uint32_t i, uint32_t end) {
+  for (; i < end; i++) {
+    if (glob->segments[i].kind != bare_fs_glob_globstar) return false;
+  }
+
+  return true;
+}
+
+static inline uint32_t
+bare_fs__glob_add_state(const bare_fs_glob_t *glob, uint32_t *next, uint32_t len, uint32_t state, int *flags) {
+  for (uint32_t i = 0; i < len; i++) {
+    if (next[i] == state) return len;
+  }
+
+  if (bare_fs__glob_rest_is_globstar(glob, state, glob->segments[state].end)) {
+    *flags |= bare_fs_glob_match_all;
+  }
+
+  next[len] = state;
+
+  return len + 1;
+}
+
+uint32_t
+bare_fs_glob_step(const bare_fs_glob_t *glob, const uint32_t *states, uint32_t len, const uint8_t *name, size_t name_len, bool directory, uint32_t *next, int *flags) {
+  bool hidden = !glob->dot && name_len > 0 && name[0] == '.';
+
+  uint32_t next_len = 0;
+
+  *flags = 0;
+
+  for (uint32_t i = 0; i < len; i++) {
+    uint32_t end = glob->segments[states[i]].end;
+
+    // Globstars also match zero segments, so keep going past them.
+    for (uint32_t j = states[i]; j < end; j++) {
+      const bare_fs_glob_segment_t *segment = &glob->segments[j];
+
+      if (segment->kind == bare_fs_glob_globstar) {
+        if (hidden) continue;
+
+        if (bare_fs__glob_rest_is_globstar(glob, j + 1, end)) *flags |= bare_fs_glob_match;
+
+        if (directory) next_len = bare_fs__glob_add_state(glob, next, next_len, j, flags);
+
+        continue;
+      }
+
+      if (bare_fs__glob_match_segment(glob, segment, name, name_len, hidden)) {
+        if (bare_fs__glob_rest_is_globstar(glob, j + 1, end)) *flags |= bare_fs_glob_match;
+
+        if (directory && j + 1 < end) {
+          next_len = bare_fs__glob_add_state(glob, next, next_len, j + 1, flags);
+        }
+      }
+
+      break;
+    }
+  }
+
+  return next_len;
+}
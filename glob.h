@@ -0,0 +1,56 @@
+#ifndef BARE_FS_GLOB_H
+#define BARE_FS_GLOB_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  bare_fs_glob_literal = 1,
+  bare_fs_glob_wildcard = 2,
+  bare_fs_glob_globstar = 3,
+};
+
+enum {
+  // The entry itself matches.
+  bare_fs_glob_match = 1,
+
+  // Every entry below the directory matches.
+  bare_fs_glob_match_all = 2,
+};
+
+typedef struct {
+  uint32_t offset;
+  uint32_t len;
+
+  // The index of the first segment after the pattern of this segment.
+  uint32_t end;
+
+  int kind;
+} bare_fs_glob_segment_t;
+
+typedef struct {
+  bool dot;
+
+  uint32_t len;
+  bare_fs_glob_segment_t segments[];
+
+  // Followed by the pattern source.
+} bare_fs_glob_t;
+
+// Returns the size of the compiled form of the patterns in `source`, which
+// are separated by NUL bytes and have their segments separated by slashes.
+size_t
+bare_fs_glob_size(const uint8_t *source, size_t len);
+
+void
+bare_fs_glob_compile(bare_fs_glob_t *glob, const uint8_t *source, size_t len, bool dot);
+
+// Advances the `states`, which are indices of segments, past a directory
+// entry. The states to continue from in the entry, if it is a directory, are
+// written to `next`, which must have room for every segment, and the number of
+// them returned. The match flags for the entry are written to `flags`.
+uint32_t
+bare_fs_glob_step(const bare_fs_glob_t *glob, const uint32_t *states, uint32_t len, const uint8_t *name, size_t name_len, bool directory, uint32_t *next, int *flags);
+
+#endif // BARE_FS_GLOB_H
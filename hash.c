@@ -0,0 +1,440 @@
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <uv.h>
+
+#if defined(__SSE4_2__)
+#include <nmmintrin.h>
+#elif defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+#include "hash.h"
+
+static inline uint32_t
+bare_fs__load32_be(const uint8_t *p) {
+  return (uint32_t) p[0] << 24 | (uint32_t) p[1] << 16 | (uint32_t) p[2] << 8 | (uint32_t) p[3];
+}
+
+static inline void
+bare_fs__store32_be(uint8_t *p, uint32_t v) {
+  p[0] = (uint8_t) (v >> 24);
+  p[1] = (uint8_t) (v >> 16);
+  p[2] = (uint8_t) (v >> 8);
+  p[3] = (uint8_t) v;
+}
+
+static inline uint64_t
+bare_fs__load64_le(const uint8_t *p) {
+  uint64_t v = 0;
+
+  for (int i = 7; i >= 0; i--) v = v << 8 | p[i];
+
+  return v;
+}
+
+static inline void
+bare_fs__store64_le(uint8_t *p, uint64_t v) {
+  for (int i = 0; i < 8; i++) p[i] = (uint8_t) (v >> (8 * i));
+}
+
+static inline uint32_t
+bare_fs__rotr32(uint32_t v, int n) {
+  return v >> n | v << (32 - n);
+}
+
+static inline uint64_t
+bare_fs__rotr64(uint64_t v, int n) {
+  return v >> n | v << (64 - n);
+}
+
+/* SHA-256, see FIPS 180-4. */
+
+static const uint32_t bare_fs__sha256_k[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+static void
+bare_fs__sha256_compress(bare_fs_sha256_t *ctx, const uint8_t *block) {
+  uint32_t w[64];
+
+  for (int i = 0; i < 16; i++) w[i] = bare_fs__load32_be(block + 4 * i);
+
+  for (int i = 16; i < 64; i++) {
+    uint32_t s0 = bare_fs__rotr32(w[i - 15], 7) ^ bare_fs__rotr32(w[i - 15], 18) ^ (w[i - 15] >> 3);
+    uint32_t s1 = bare_fs__rotr32(w[i - 2], 17) ^ bare_fs__rotr32(w[i - 2], 19) ^ (w[i - 2] >> 10);
+
+    w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+  }
+
+  uint32_t a = ctx->state[0], b = ctx->state[1], c = ctx->state[2], d = ctx->state[3];
+  uint32_t e = ctx->state[4], f = ctx->state[5], g = ctx->state[6], h = ctx->state[7];
+
+  for (int i = 0; i < 64; i++) {
+    uint32_t s1 = bare_fs__rotr32(e, 6) ^ bare_fs__rotr32(e, 11) ^ bare_fs__rotr32(e, 25);
+    uint32_t ch = (e & f) ^ (~e & g);
+    uint32_t t1 = h + s1 + ch + bare_fs__sha256_k[i] + w[i];
+    uint32_t s0 = bare_fs__rotr32(a, 2) ^ bare_fs__rotr32(a, 13) ^ bare_fs__rotr32(a, 22);
+    uint32_t maj = (a & b) ^ (a & c) ^ (b & c);
+    uint32_t t2 = s0 + maj;
+
+    h = g;
+    g = f;
+    f = e;
+    e = d + t1;
+    d = c;
+    c = b;
+    b = a;
+    a = t1 + t2;
+  }
+
+  ctx->state[0] += a;
+  ctx->state[1] += b;
+  ctx->state[2] += c;
+  ctx->state[3] += d;
+  ctx->state[4] += e;
+  ctx->state[5] += f;
+  ctx->state[6] += g;
+  ctx->state[7] += h;
+}
+
+static void
+bare_fs__sha256_init(bare_fs_sha256_t *ctx) {
+  static const uint32_t iv[8] = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+  };
+
+  memcpy(ctx->state, iv, sizeof(iv));
+
+  ctx->len = 0;
+  ctx->block_len = 0;
+}
+
+static void
+bare_fs__sha256_update(bare_fs_sha256_t *ctx, const uint8_t *data, size_t len) {
+  ctx->len += len;
+
+  if (ctx->block_len) {
+    size_t n = 64 - ctx->block_len;
+    if (n > len) n = len;
+
+    memcpy(ctx->block + ctx->block_len, data, n);
+
+    ctx->block_len += n;
+    data += n;
+    len -= n;
+
+    if (ctx->block_len < 64) return;
+
+    bare_fs__sha256_compress(ctx, ctx->block);
+
+    ctx->block_len = 0;
+  }
+
+  while (len >= 64) {
+    bare_fs__sha256_compress(ctx, data);
+
+    data += 64;
+    len -= 64;
+  }
+
+  memcpy(ctx->block, data, len);
+
+  ctx->block_len = len;
+}
+
+static void
+bare_fs__sha256_final(bare_fs_sha256_t *ctx, uint8_t *digest) {
+  uint64_t bits = ctx->len * 8;
+
+  ctx->block[ctx->block_len++] = 0x80;
+
+  if (ctx->block_len > 56) {
+    memset(ctx->block + ctx->block_len, 0, 64 - ctx->block_len);
+
+    bare_fs__sha256_compress(ctx, ctx->block);
+
+    ctx->block_len = 0;
+  }
+
+  memset(ctx->block + ctx->block_len, 0, 56 - ctx->block_len);
+
+  for (int i = 0; i < 8; i++) ctx->block[63 - i] = (uint8_t) (bits >> (8 * i));
+
+  bare_fs__sha256_compress(ctx, ctx->block);
+
+  for (int i = 0; i < 8; i++) bare_fs__store32_be(digest + 4 * i, ctx->state[i]);
+}
+
+/* BLAKE2b, see RFC 7693. */
+
+static const uint64_t bare_fs__blake2b_iv[8] = {
+  0x6a09e667f3bcc908ULL,
+  0xbb67ae8584caa73bULL,
+  0x3c6ef372fe94f82bULL,
+  0xa54ff53a5f1d36f1ULL,
+  0x510e527fade682d1ULL,
+  0x9b05688c2b3e6c1fULL,
+  0x1f83d9abfb41bd6bULL,
+  0x5be0cd19137e2179ULL,
+};
+
+static const uint8_t bare_fs__blake2b_sigma[12][16] = {
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+  {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+  {11, 8, 12, 0, 5, 2, 15, 13, 10, 14, 3, 6, 7, 1, 9, 4},
+  {7, 9, 3, 1, 13, 12, 11, 14, 2, 6, 5, 10, 4, 0, 15, 8},
+  {9, 0, 5, 7, 2, 4, 10, 15, 14, 1, 11, 12, 6, 8, 3, 13},
+  {2, 12, 6, 10, 0, 11, 8, 3, 4, 13, 7, 5, 15, 14, 1, 9},
+  {12, 5, 1, 15, 14, 13, 4, 10, 0, 7, 6, 3, 9, 2, 8, 11},
+  {13, 11, 7, 14, 12, 1, 3, 9, 5, 0, 15, 4, 8, 6, 2, 10},
+  {6, 15, 14, 9, 11, 3, 0, 8, 12, 2, 13, 7, 1, 4, 10, 5},
+  {10, 2, 8, 4, 7, 6, 1, 5, 15, 11, 9, 14, 3, 12, 13, 0},
+  {0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15},
+  {14, 10, 4, 8, 9, 15, 13, 6, 1, 12, 0, 2, 11, 7, 5, 3},
+};
+
+static void
+bare_fs__blake2b_compress(bare_fs_blake2b_t *ctx, const uint8_t *block, bool last) {
+  uint64_t m[16], v[16];
+
+  for (int i = 0; i < 16; i++) m[i] = bare_fs__load64_le(block + 8 * i);
+
+  for (int i = 0; i < 8; i++) {
+    v[i] = ctx->state[i];
+    v[i + 8] = bare_fs__blake2b_iv[i];
+  }
+
+  v[12] ^= ctx->counter[0];
+  v[13] ^= ctx->counter[1];
+
+  if (last) v[14] = ~v[14];
+
+#define G(a, b, c, d, x, y) \
+  { \
+    v[a] = v[a] + v[b] + x; \
+    v[d] = bare_fs__rotr64(v[d] ^ v[a], 32); \
+    v[c] = v[c] + v[d]; \
+    v[b] = bare_fs__rotr64(v[b] ^ v[c], 24); \
+    v[a] = v[a] + v[b] + y; \
+    v[d] = bare_fs__rotr64(v[d] ^ v[a], 16); \
+    v[c] = v[c] + v[d]; \
+    v[b] = bare_fs__rotr64(v[b] ^ v[c], 63); \
+  }
+
+  for (int i = 0; i < 12; i++) {
+    const uint8_t *s = bare_fs__blake2b_sigma[i];
+
+    G(0, 4, 8, 12, m[s[0]], m[s[1]])
+    G(1, 5, 9, 13, m[s[2]], m[s[3]])
+    G(2, 6, 10, 14, m[s[4]], m[s[5]])
+    G(3, 7, 11, 15, m[s[6]], m[s[7]])
+    G(0, 5, 10, 15, m[s[8]], m[s[9]])
+    G(1, 6, 11, 12, m[s[10]], m[s[11]])
+    G(2, 7, 8, 13, m[s[12]], m[s[13]])
+    G(3, 4, 9, 14, m[s[14]], m[s[15]])
+  }
+#undef G
+
+  for (int i = 0; i < 8; i++) ctx->state[i] ^= v[i] ^ v[i + 8];
+}
+
+static inline void
+bare_fs__blake2b_increment(bare_fs_blake2b_t *ctx, uint64_t n) {
+  ctx->counter[0] += n;
+
+  if (ctx->counter[0] < n) ctx->counter[1]++;
+}
+
+static void
+bare_fs__blake2b_init(bare_fs_blake2b_t *ctx) {
+  memcpy(ctx->state, bare_fs__blake2b_iv, sizeof(ctx->state));
+
+  // Parameter block: digest length 64, no key, fanout 1, depth 1.
+  ctx->state[0] ^= 0x01010000 ^ 64;
+
+  ctx->counter[0] = 0;
+  ctx->counter[1] = 0;
+  ctx->block_len = 0;
+}
+
+static void
+bare_fs__blake2b_update(bare_fs_blake2b_t *ctx, const uint8_t *data, size_t len) {
+  while (len > 0) {
+    // The final block must be compressed with the finalization flag set, so a
+    // full block is only compressed once more input is known to follow.
+    if (ctx->block_len == 128) {
+      bare_fs__blake2b_increment(ctx, 128);
+      bare_fs__blake2b_compress(ctx, ctx->block, false);
+
+      ctx->block_len = 0;
+    }
+
+    size_t n = 128 - ctx->block_len;
+    if (n > len) n = len;
+
+    memcpy(ctx->block + ctx->block_len, data, n);
+
+    ctx->block_len += n;
+    data += n;
+    len -= n;
+  }
+}
+
+static void
+bare_fs__blake2b_final(bare_fs_blake2b_t *ctx, uint8_t *digest) {
+  bare_fs__blake2b_increment(ctx, ctx->block_len);
+
+  memset(ctx->block + ctx->block_len, 0, 128 - ctx->block_len);
+
+  bare_fs__blake2b_compress(ctx, ctx->block, true);
+
+  for (int i = 0; i < 8; i++) bare_fs__store64_le(digest + 8 * i, ctx->state[i]);
+}
+
+/* CRC-32C (Castagnoli), using the CRC32 instructions when available. */
+
+#if !defined(__SSE4_2__) && !defined(__ARM_FEATURE_CRC32)
+
+static uint32_t bare_fs__crc32c_table[8][256];
+
+static uv_once_t bare_fs__crc32c_guard = UV_ONCE_INIT;
+
+static void
+bare_fs__crc32c_init_table(void) {
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = i;
+
+    for (int j = 0; j < 8; j++) crc = crc & 1 ? crc >> 1 ^ 0x82f63b78 : crc >> 1;
+
+    bare_fs__crc32c_table[0][i] = crc;
+  }
+
+  for (uint32_t i = 0; i < 256; i++) {
+    uint32_t crc = bare_fs__crc32c_table[0][i];
+
+    for (int j = 1; j < 8; j++) {
+      crc = bare_fs__crc32c_table[0][crc & 0xff] ^ crc >> 8;
+
+      bare_fs__crc32c_table[j][i] = crc;
+    }
+  }
+}
+
+#endif
+
+static uint32_t
+bare_fs__crc32c_update(uint32_t crc, const uint8_t *data, size_t len) {
+#if defined(__SSE4_2__)
+  uint64_t crc64 = crc;
+
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+
+    crc64 = _mm_crc32_u64(crc64, word);
+
+    data += 8;
+    len -= 8;
+  }
+
+  crc = (uint32_t) crc64;
+
+  while (len--) crc = _mm_crc32_u8(crc, *data++);
+#elif defined(__ARM_FEATURE_CRC32)
+  while (len >= 8) {
+    uint64_t word;
+    memcpy(&word, data, 8);
+
+    crc = __crc32cd(crc, word);
+
+    data += 8;
+    len -= 8;
+  }
+
+  while (len--) crc = __crc32cb(crc, *data++);
+#else
+  uv_once(&bare_fs__crc32c_guard, bare_fs__crc32c_init_table);
+
+  const uint32_t(*t)[256] = (const uint32_t(*)[256]) bare_fs__crc32c_table;
+
+  while (len >= 8) {
+    uint32_t lo = crc ^ ((uint32_t) data[0] | (uint32_t) data[1] << 8 | (uint32_t) data[2] << 16 | (uint32_t) data[3] << 24);
+    uint32_t hi = (uint32_t) data[4] | (uint32_t) data[5] << 8 | (uint32_t) data[6] << 16 | (uint32_t) data[7] << 24;
+
+    crc = t[7][lo & 0xff] ^ t[6][(lo >> 8) & 0xff] ^ t[5][(lo >> 16) & 0xff] ^ t[4][lo >> 24] ^
+          t[3][hi & 0xff] ^ t[2][(hi >> 8) & 0xff] ^ t[1][(hi >> 16) & 0xff] ^ t[0][hi >> 24];
+
+    data += 8;
+    len -= 8;
+  }
+
+  while (len--) crc = t[0][(crc ^ *data++) & 0xff] ^ crc >> 8;
+#endif
+
+  return crc;
+}
+
+size_t
+bare_fs_hash_init(bare_fs_hash_t *hash, int algorithm) {
+  hash->algorithm = algorithm;
+
+  switch (algorithm) {
+  case bare_fs_hash_sha256:
+    bare_fs__sha256_init(&hash->sha256);
+    return 32;
+
+  case bare_fs_hash_blake2b512:
+    bare_fs__blake2b_init(&hash->blake2b);
+    return 64;
+
+  case bare_fs_hash_crc32c:
+    hash->crc32c = 0xffffffff;
+    return 4;
+
+  default:
+    return 0;
+  }
+}
+
+void
+bare_fs_hash_update(bare_fs_hash_t *hash, const uint8_t *data, size_t len) {
+  switch (hash->algorithm) {
+  case bare_fs_hash_sha256:
+    bare_fs__sha256_update(&hash->sha256, data, len);
+    break;
+
+  case bare_fs_hash_blake2b512:
+    bare_fs__blake2b_update(&hash->blake2b, data, len);
+    break;
+
+  case bare_fs_hash_crc32c:
+    hash->crc32c = bare_fs__crc32c_update(hash->crc32c, data, len);
+    break;
+  }
+}
+
+void
+bare_fs_hash_final(bare_fs_hash_t *hash, uint8_t *digest) {
+  switch (hash->algorithm) {
+  case bare_fs_hash_sha256:
+    bare_fs__sha256_final(&hash->sha256, digest);
+    break;
+
+  case bare_fs_hash_blake2b512:
+    bare_fs__blake2b_final(&hash->blake2b, digest);
+    break;
+
+  case bare_fs_hash_crc32c:
+    bare_fs__store32_be(digest, ~hash->crc32c);
+    break;
+  }
+}
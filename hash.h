@@ -0,0 +1,49 @@
+#ifndef BARE_FS_HASH_H
+#define BARE_FS_HASH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+enum {
+  bare_fs_hash_sha256 = 1,
+  bare_fs_hash_blake2b512 = 2,
+  bare_fs_hash_crc32c = 3,
+};
+
+typedef struct {
+  uint32_t state[8];
+  uint64_t len;
+  uint8_t block[64];
+  size_t block_len;
+} bare_fs_sha256_t;
+
+typedef struct {
+  uint64_t state[8];
+  uint64_t counter[2];
+  uint8_t block[128];
+  size_t block_len;
+} bare_fs_blake2b_t;
+
+typedef struct {
+  int algorithm;
+
+  union {
+    bare_fs_sha256_t sha256;
+    bare_fs_blake2b_t blake2b;
+    uint32_t crc32c;
+  };
+} bare_fs_hash_t;
+
+#define BARE_FS_HASH_MAX_DIGEST_LEN 64
+
+// Returns the digest length of the algorithm, or 0 if it is not supported.
+size_t
+bare_fs_hash_init(bare_fs_hash_t *hash, int algorithm);
+
+void
+bare_fs_hash_update(bare_fs_hash_t *hash, const uint8_t *data, size_t len);
+
+void
+bare_fs_hash_final(bare_fs_hash_t *hash, uint8_t *digest);
+
+#endif // BARE_FS_HASH_H
@@ -58,6 +58,7 @@ export interface Dirent<T extends string | Buffer = string | Buffer> {
   readonly parentPath: string
   readonly name: T
   readonly type: number
+  readonly stats: Stats | null
 
   isFile(): boolean
   isDirectory(): boolean
@@ -69,7 +70,7 @@ export interface Dirent<T extends string | Buffer = string | Buffer> {
 }
 
 export class Dirent<T extends string | Buffer = string | Buffer> {
-  private constructor(parentPath: string, name: T, type: number)
+  private constructor(parentPath: string, name: T, type: number, stats?: Stats | null)
 }
 
 export interface Stats {
@@ -144,12 +145,33 @@ export class StatFs {
   )
 }
 
+export interface BufferPoolOptions {
+  slabSize?: number
+  maxFreeSlabs?: number
+}
+
+export interface BufferPool {
+  readonly slabSize: number
+  readonly maxFreeSlabs: number
+  readonly size: number
+
+  alloc(size: number): Buffer
+  release(buffer: ArrayBufferView): void
+}
+
+export class BufferPool {
+  constructor(opts?: BufferPoolOptions)
+}
+
 export interface ReadStreamOptions {
   fd?: number
   flags?: Flag
   mode?: number
   start?: number
   end?: number
+  sparse?: boolean
+  direct?: boolean
+  pool?: BufferPool | null
 }
 
 export interface ReadStream extends Readable {
@@ -157,6 +179,9 @@ export interface ReadStream extends Readable {
   readonly fd: number
   readonly flags: Flag
   readonly mode: number
+  readonly sparse: boolean
+  readonly direct: boolean
+  readonly pool: BufferPool | null
 }
 
 export class ReadStream {
@@ -165,10 +190,20 @@ export class ReadStream {
 
 export function createReadStream(path: Path | null, opts?: ReadStreamOptions): ReadStream
 
+export interface WritebackOptions {
+  window?: number
+  dropCache?: boolean
+}
+
 export interface WriteStreamOptions {
   fd?: number
   flags?: Flag
   mode?: number
+  start?: number
+  concurrency?: number
+  preallocate?: number
+  direct?: boolean
+  writeback?: boolean | WritebackOptions
 }
 
 export interface WriteStream extends Writable {
@@ -176,6 +211,11 @@ export interface WriteStream extends Writable {
   readonly fd: number
   readonly flags: Flag
   readonly mode: number
+  readonly start: number | null
+  readonly concurrency: number
+  readonly preallocate: number
+  readonly direct: boolean
+  readonly writeback: Required<WritebackOptions> | null
 }
 
 export class WriteStream {
@@ -211,6 +251,133 @@ export class Watcher {
   private constructor(path: Path, opts: WatcherOptions)
 }
 
+export interface StatWatcherOptions {
+  interval?: number
+  jitter?: number
+  persistent?: boolean
+}
+
+export interface StatWatcherChange {
+  filename: string
+  curr: Stats
+  prev: Stats
+}
+
+export interface StatWatcherEvents extends EventMap {
+  error: [err: Error]
+  change: [changes: StatWatcherChange[]]
+  close: []
+}
+
+export interface StatWatcher extends EventEmitter<StatWatcherEvents> {
+  readonly interval: number
+  readonly jitter: number
+  readonly size: number
+
+  has(filename: Path): boolean
+  add(filename: Path): this
+  delete(filename: Path): boolean
+  close(): void
+  ref(): this
+  unref(): this
+}
+
+export class StatWatcher {
+  constructor(
+    filenames?: Iterable<Path>,
+    opts?: StatWatcherOptions,
+    onchange?: (changes: StatWatcherChange[]) => void
+  )
+
+  constructor(filenames: Iterable<Path>, onchange: (changes: StatWatcherChange[]) => void)
+}
+
+export interface StatCacheOptions {
+  ttl?: number
+  maxSize?: number
+}
+
+export interface StatCacheWatchOptions {
+  recursive?: boolean
+}
+
+export interface StatCache extends Disposable {
+  readonly hits: number
+  readonly misses: number
+  readonly size: number
+
+  watch(root: Path, opts?: StatCacheWatchOptions): Watcher
+  invalidate(filepath: Path): void
+  clear(): void
+  close(): void
+}
+
+export class StatCache {
+  constructor(opts?: StatCacheOptions)
+}
+
+export interface RealpathCacheOptions extends StatCacheOptions {}
+
+export interface RealpathCache extends Disposable {
+  readonly hits: number
+  readonly misses: number
+  readonly size: number
+
+  watch(root: Path, opts?: StatCacheWatchOptions): Watcher
+  invalidate(filepath: Path): void
+  clear(): void
+  close(): void
+}
+
+export class RealpathCache {
+  constructor(opts?: RealpathCacheOptions)
+}
+
+export interface LogWriterOptions {
+  position?: number
+  maxBatchSize?: number
+  commitDelay?: number
+  sync?: boolean
+}
+
+export interface LogWriter extends AsyncDisposable {
+  readonly fd: number
+  readonly position: number
+
+  append(data: string | Buffer | ArrayBufferView): Promise<number>
+  flush(): Promise<void>
+  close(): Promise<void>
+}
+
+export class LogWriter {
+  constructor(fd: number, opts?: LogWriterOptions)
+}
+
+export interface TreeIndex {
+  readonly root: string
+  readonly path: string
+  readonly size: number
+
+  entries(dirpath: Path): Dirent[] | null
+  load(): Promise<boolean>
+  scan(): Promise<string[]>
+  save(): Promise<void>
+  watch(): Watcher
+  close(): void
+}
+
+export class TreeIndex {
+  constructor(root: Path, filepath: Path)
+}
+
+export interface StatOptions {
+  cache?: StatCache
+}
+
+export interface ExistsOptions {
+  cache?: StatCache
+}
+
 export function access(filepath: Path, mode?: number): Promise<void>
 
 export function access(filepath: Path, mode: number, cb: Callback): void
@@ -219,6 +386,16 @@ export function access(filepath: Path, cb: Callback): void
 
 export function accessSync(filepath: Path, mode?: number): void
 
+export function tryAccess(filepath: Path, mode?: number): Promise<number>
+
+export function tryAccess(filepath: Path, mode: number, cb: Callback<[status: number]>): void
+
+export function tryAccess(filepath: Path, cb: Callback<[status: number]>): void
+
+export function tryAccessSync(filepath: Path, mode?: number): number
+
+export function allocAligned(size: number, alignment?: number): Buffer
+
 export interface AppendFileOptions {
   encoding?: BufferEncoding
   flag?: string
@@ -287,16 +464,27 @@ export function close(fd: number, cb: Callback): void
 
 export function closeSync(fd: number): void
 
-export function copyFile(src: Path, dst: Path, mode?: number): Promise<void>
+export interface CopyFileOptions {
+  mode?: number
+  sparse?: boolean
+}
+
+export function copyFile(src: Path, dst: Path, mode?: number | CopyFileOptions): Promise<void>
 
-export function copyFile(src: Path, dst: Path, mode: number, cb: Callback): void
+export function copyFile(
+  src: Path,
+  dst: Path,
+  mode: number | CopyFileOptions,
+  cb: Callback
+): void
 
 export function copyFile(src: Path, dst: Path, cb: Callback): void
 
-export function copyFileSync(src: Path, dst: Path, mode?: number): void
+export function copyFileSync(src: Path, dst: Path, mode?: number | CopyFileOptions): void
 
 export interface CpOptions {
   recursive?: boolean
+  sparse?: boolean
 }
 
 export function cp(src: Path, dst: Path, opts?: CpOptions): Promise<void>
@@ -307,11 +495,52 @@ export function cp(src: Path, dst: Path, cb: Callback): void
 
 export function cpSync(src: Path, dst: Path, opts?: CpOptions): void
 
-export function exists(filepath: Path): Promise<boolean>
+export interface DataRange {
+  offset: number
+  length: number
+}
+
+export function dataRanges(fd: number, offset?: number): AsyncIterableIterator<DataRange>
+
+export function dataRangesSync(fd: number, offset?: number): IterableIterator<DataRange>
+
+export interface DiskUsageOptions {
+  apparent?: boolean
+  countHardlinksOnce?: boolean
+  maxDepth?: number
+  children?: boolean
+  concurrency?: number
+}
+
+export interface DiskUsage {
+  bytes: number
+  blocks: number
+  inodes: number
+}
+
+export interface DiskUsageResult extends DiskUsage {
+  children?: (DiskUsage & { name: string })[]
+}
+
+export function du(filepath: Path, opts?: DiskUsageOptions): Promise<DiskUsageResult>
+
+export function du(
+  filepath: Path,
+  opts: DiskUsageOptions,
+  cb: Callback<[usage: DiskUsageResult | null]>
+): void
+
+export function du(filepath: Path, cb: Callback<[usage: DiskUsageResult | null]>): void
+
+export function duSync(filepath: Path, opts?: DiskUsageOptions): DiskUsageResult
+
+export function exists(filepath: Path, opts?: ExistsOptions): Promise<boolean>
+
+export function exists(filepath: Path, opts: ExistsOptions, cb: (exists: boolean) => void): void
 
 export function exists(filepath: Path, cb: (exists: boolean) => void): void
 
-export function existsSync(filepath: Path): boolean
+export function existsSync(filepath: Path, opts?: ExistsOptions): boolean
 
 export function fchmod(fd: number, mode: string | number): Promise<void>
 
@@ -351,17 +580,54 @@ export function ftruncate(fd: number, cb: Callback): void
 
 export function ftruncateSync(fd: number, len?: number): void
 
+export interface FallocateOptions {
+  keepSize?: boolean
+  punchHole?: boolean
+  zeroRange?: boolean
+  collapseRange?: boolean
+}
+
+export function fallocate(
+  fd: number,
+  offset: number,
+  len: number,
+  opts?: FallocateOptions
+): Promise<void>
+
+export function fallocate(
+  fd: number,
+  offset: number,
+  len: number,
+  opts: FallocateOptions,
+  cb: Callback
+): void
+
+export function fallocate(fd: number, offset: number, len: number, cb: Callback): void
+
+export function fallocateSync(
+  fd: number,
+  offset: number,
+  len: number,
+  opts?: FallocateOptions
+): void
+
 export function lchown(filepath: Path, uid: number, gid: number): Promise<void>
 
 export function lchown(filepath: Path, uid: number, gid: number, cb: Callback): void
 
 export function lchownSync(filepath: Path, uid: number, gid: number): void
 
-export function lstat(filepath: Path): Promise<Stats>
+export function lstat(filepath: Path, opts?: StatOptions): Promise<Stats>
+
+export function lstat(
+  filepath: Path,
+  opts: StatOptions,
+  cb: Callback<[stats: Stats | null]>
+): void
 
 export function lstat(filepath: Path, cb: Callback<[stats: Stats | null]>): void
 
-export function lstatSync(filepath: Path): Stats
+export function lstatSync(filepath: Path, opts?: StatOptions): Stats
 
 export function utimes(filepath: Path, atime: number | Date, mtime: number | Date): Promise<void>
 
@@ -391,6 +657,76 @@ export function futimes(fd: number, atime: number | Date, mtime: number | Date,
 
 export function futimesSync(fd: number, atime: number | Date, mtime: number | Date): void
 
+export type HashAlgorithm = 'sha256' | 'blake2b512' | 'crc32c'
+
+export interface HashFileOptions {
+  algorithm?: HashAlgorithm
+  offset?: number
+  length?: number
+  encoding?: BufferEncoding | 'buffer'
+}
+
+export function hashFile(
+  filepath: Path | number,
+  opts: HashFileOptions & { encoding: BufferEncoding }
+): Promise<string>
+
+export function hashFile(
+  filepath: Path | number,
+  opts?: (HashFileOptions & { encoding?: 'buffer' }) | HashAlgorithm
+): Promise<Buffer>
+
+export function hashFile(
+  filepath: Path | number,
+  opts: HashFileOptions & { encoding: BufferEncoding },
+  cb: Callback<[digest: string | null]>
+): void
+
+export function hashFile(
+  filepath: Path | number,
+  opts: (HashFileOptions & { encoding?: 'buffer' }) | HashAlgorithm,
+  cb: Callback<[digest: Buffer | null]>
+): void
+
+export function hashFile(
+  filepath: Path | number,
+  cb: Callback<[digest: Buffer | null]>
+): void
+
+export function hashFileSync(
+  filepath: Path | number,
+  opts: HashFileOptions & { encoding: BufferEncoding }
+): string
+
+export function hashFileSync(
+  filepath: Path | number,
+  opts?: (HashFileOptions & { encoding?: 'buffer' }) | HashAlgorithm
+): Buffer
+
+export interface SnapshotOptions {
+  algorithm?: HashAlgorithm
+  contents?: boolean
+}
+
+export function snapshot(root: Path, opts?: SnapshotOptions): Promise<Buffer>
+
+export function snapshot(
+  root: Path,
+  opts: SnapshotOptions,
+  cb: Callback<[manifest: Buffer | null]>
+): void
+
+export function snapshot(root: Path, cb: Callback<[manifest: Buffer | null]>): void
+
+export function snapshotSync(root: Path, opts?: SnapshotOptions): Buffer
+
+export interface SnapshotChange {
+  type: 'add' | 'remove' | 'change'
+  path: string
+}
+
+export function diff(a: Buffer, b: Buffer): SnapshotChange[]
+
 export function link(src: Path, dst: Path): Promise<void>
 
 export function link(src: Path, dst: Path, cb: Callback): void
@@ -437,9 +773,38 @@ export function open(filepath: Path, cb: Callback<[fd: number]>): void
 
 export function openSync(filepath: Path, flags?: Flag | number, mode?: string | number): number
 
+export function tryOpen(
+  filepath: Path,
+  flags?: Flag | number,
+  mode?: string | number
+): Promise<number>
+
+export function tryOpen(
+  filepath: Path,
+  flags: Flag | number,
+  mode: string | number,
+  cb: Callback<[status: number]>
+): void
+
+export function tryOpen(
+  filepath: Path,
+  flags: Flag | number,
+  cb: Callback<[status: number]>
+): void
+
+export function tryOpen(filepath: Path, cb: Callback<[status: number]>): void
+
+export function tryOpenSync(
+  filepath: Path,
+  flags?: Flag | number,
+  mode?: string | number
+): number
+
 export interface OpendirOptions {
   encoding?: BufferEncoding | 'buffer'
   bufferSize?: number
+  maxBufferSize?: number
+  withStats?: boolean
 }
 
 export function opendir(
@@ -565,6 +930,9 @@ export function readSync(
 export interface ReadFileOptions {
   encoding?: BufferEncoding | 'buffer'
   flag?: Flag
+  parallel?: number
+  direct?: boolean
+  pool?: BufferPool | null
 }
 
 export function readFile(
@@ -644,6 +1012,33 @@ export function readFileSync(filepath: Path, encoding?: BufferEncoding | 'buffer
 
 export function readFileSync(filepath: Path): Buffer
 
+export interface ReadLinesOptions {
+  encoding?: BufferEncoding | 'buffer'
+  maxLineLength?: number
+  batch?: number
+  position?: number
+}
+
+export function readLines(
+  filepath: Path | number,
+  opts: ReadLinesOptions & { encoding: 'buffer' }
+): AsyncIterableIterator<Buffer[]>
+
+export function readLines(
+  filepath: Path | number,
+  opts?: ReadLinesOptions | BufferEncoding
+): AsyncIterableIterator<string[]>
+
+export function readLinesSync(
+  filepath: Path | number,
+  opts: ReadLinesOptions & { encoding: 'buffer' }
+): IterableIterator<Buffer[]>
+
+export function readLinesSync(
+  filepath: Path | number,
+  opts?: ReadLinesOptions | BufferEncoding
+): IterableIterator<string[]>
+
 export interface ReaddirOptions extends OpendirOptions {
   withFileTypes?: boolean
 }
@@ -830,6 +1225,17 @@ export function readdirSync(
 
 export function readdirSync(filepath: Path): string[]
 
+export interface GlobOptions {
+  cwd?: Path
+  ignore?: string | string[]
+  dot?: boolean
+  onlyFiles?: boolean
+}
+
+export function glob(patterns: string | string[], opts?: GlobOptions): AsyncIterableIterator<string>
+
+export function globSync(patterns: string | string[], opts?: GlobOptions): IterableIterator<string>
+
 export interface ReadlinkOptions {
   encoding?: BufferEncoding | 'buffer'
 }
@@ -925,8 +1331,48 @@ export function readv(fd: number, buffers: ArrayBufferView[], cb: Callback<[len:
 
 export function readvSync(fd: number, buffers: ArrayBufferView[], position?: number): number
 
+export interface ManyOperation {
+  buffer: Buffer | ArrayBufferView
+  position?: number
+  offset?: number
+  length?: number
+}
+
+export function readMany(fd: number, ops: ManyOperation[]): Promise<number[]>
+
+export function readMany(fd: number, ops: ManyOperation[], cb: Callback<[lens: number[]]>): void
+
+export function readManySync(fd: number, ops: ManyOperation[]): number[]
+
+export interface ReadParallelOptions {
+  position?: number
+  length?: number
+  chunkSize?: number
+  concurrency?: number
+}
+
+export function readParallel(
+  fd: number,
+  buffer: Buffer | ArrayBufferView,
+  opts?: ReadParallelOptions
+): Promise<number>
+
+export function readParallel(
+  fd: number,
+  buffer: Buffer | ArrayBufferView,
+  opts: ReadParallelOptions,
+  cb: Callback<[len: number]>
+): void
+
+export function readParallel(
+  fd: number,
+  buffer: Buffer | ArrayBufferView,
+  cb: Callback<[len: number]>
+): void
+
 export interface RealpathOptions {
   encoding?: BufferEncoding | 'buffer'
+  cache?: RealpathCache
 }
 
 export function realpath(
@@ -1032,11 +1478,23 @@ export function rmdir(filepath: Path, cb: Callback): void
 
 export function rmdirSync(filepath: Path): void
 
-export function stat(filepath: Path): Promise<Stats>
+export function stat(filepath: Path, opts?: StatOptions): Promise<Stats>
+
+export function stat(
+  filepath: Path,
+  opts: StatOptions,
+  cb: Callback<[stats: Stats | null]>
+): void
 
 export function stat(filepath: Path, cb: Callback<[stats: Stats | null]>): void
 
-export function statSync(filepath: Path): Stats
+export function statSync(filepath: Path, opts?: StatOptions): Stats
+
+export function tryStat(filepath: Path): Promise<Stats | null>
+
+export function tryStat(filepath: Path, cb: Callback<[stats: Stats | null]>): void
+
+export function tryStatSync(filepath: Path): Stats | null
 
 export function statfs(filepath: Path): Promise<StatFs>
 
@@ -1107,6 +1565,16 @@ export function watch(
   cb: (eventType: WatcherEventType, filename: string) => void
 ): Watcher<string>
 
+export function watchFile(
+  filepath: Path,
+  opts: StatWatcherOptions,
+  listener: (curr: Stats, prev: Stats) => void
+): StatWatcher
+
+export function watchFile(filepath: Path, listener: (curr: Stats, prev: Stats) => void): StatWatcher
+
+export function unwatchFile(filepath: Path, listener?: (curr: Stats, prev: Stats) => void): void
+
 export function write(
   fd: number,
   data: Buffer | ArrayBufferView,
@@ -1174,6 +1642,7 @@ export interface WriteFileOptions {
   encoding?: BufferEncoding
   flag?: Flag
   mode?: number
+  writeback?: boolean | WritebackOptions
 }
 
 export function writeFile(
@@ -1232,3 +1701,19 @@ export function writev(
 export function writev(fd: number, buffers: ArrayBufferView[], cb: Callback<[len: number]>): void
 
 export function writevSync(fd: number, buffers: ArrayBufferView[], pos?: number): number
+
+export function writeMany(
+  fd: number,
+  ops: (ManyOperation | (Omit<ManyOperation, 'buffer'> & { buffer: string }))[]
+): Promise<number[]>
+
+export function writeMany(
+  fd: number,
+  ops: (ManyOperation | (Omit<ManyOperation, 'buffer'> & { buffer: string }))[],
+  cb: Callback<[lens: number[]]>
+): void
+
+export function writeManySync(
+  fd: number,
+  ops: (ManyOperation | (Omit<ManyOperation, 'buffer'> & { buffer: string }))[]
+): number[]
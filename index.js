@@ -35,6 +35,13 @@ class FileRequest {
     this._retain = value // Tie the lifetime of `value` to the lifetime of `this`
   }
 
+  // Report failures as negative statuses instead of errors until reset.
+  probe() {
+    binding.requestProbe(this._handle)
+
+    return this
+  }
+
   reset() {
     if (this._handle === null) return this
 
@@ -56,7 +63,38 @@ class FileRequest {
     return this
   }
 
+  // Report the result of the request straight from the native result callback,
+  // either to `cb` or, if omitted, through the returned promise. This avoids
+  // the promises otherwise allocated for the request and its caller. Failures
+  // are reported as a `FileError` for `operation` and successes as the result
+  // of `map(handle, status)`, or `undefined` if `map` is `null`. The request is
+  // returned to the pool before the result is reported.
+  complete(operation, path, fd, map, cb) {
+    this._complete = true
+    this._operation = operation
+    this._path = path
+    this._fd = fd
+    this._map = map
+
+    if (cb) {
+      this._callback = cb
+      return
+    }
+
+    return new Promise((resolve, reject) => {
+      this._resolve = resolve
+      this._reject = reject
+    })
+  }
+
   then(resolve, reject) {
+    if (this._promise === null) {
+      this._promise = new Promise((resolve, reject) => {
+        this._resolve = resolve
+        this._reject = reject
+      })
+    }
+
     return this._promise.then(resolve, reject)
   }
 
@@ -69,17 +107,51 @@ class FileRequest {
   }
 
   _reset() {
-    this._promise = new Promise((resolve, reject) => {
-      this._resolve = resolve
-      this._reject = reject
-    })
+    this._promise = null
+    this._resolve = null
+    this._reject = null
     this._retain = null
+    this._complete = false
+    this._operation = null
+    this._path = null
+    this._fd = -1
+    this._map = null
+    this._callback = null
   }
 
   _onresult(err, status) {
-    if (err) this._reject(err)
+    if (this._complete) this._oncomplete(err, status)
+    else if (this._promise === null) {
+      this._promise = err ? Promise.reject(err) : Promise.resolve(status)
+    } else if (err) this._reject(err)
     else this._resolve(status)
   }
+
+  _oncomplete(err, status) {
+    const cb = this._callback
+    const resolve = this._resolve
+    const reject = this._reject
+
+    let result
+    if (err) {
+      err = new FileError(err.message, {
+        operation: this._operation,
+        code: err.code,
+        path: this._path,
+        fd: this._fd
+      })
+    } else if (this._map !== null) {
+      result = this._map(this._handle, status)
+    }
+
+    this.return()
+
+    if (cb !== null) {
+      if (err) cb(err)
+      else cb(null, result)
+    } else if (err) reject(err)
+    else resolve(result)
+  }
 }
 
 FileRequest._free = []
@@ -109,7 +181,15 @@ function done(err, result, cb) {
   else return ok(result, cb)
 }
 
-async function open(filepath, flags = 'r', mode = 0o666, cb) {
+function toStatus(handle, status) {
+  return status
+}
+
+function toStats(handle) {
+  return new Stats(...binding.requestResultStat(handle))
+}
+
+function open(filepath, flags = 'r', mode = 0o666, cb) {
   if (typeof flags === 'function') {
     cb = flags
     flags = 'r'
@@ -126,23 +206,15 @@ async function open(filepath, flags = 'r', mode = 0o666, cb) {
 
   const req = FileRequest.borrow()
 
-  let fd
-  let err = null
+  const result = req.complete('open', filepath, -1, toStatus, cb)
+
   try {
     binding.open(req.handle, filepath, flags, mode)
-
-    fd = await req
   } catch (e) {
-    err = new FileError(e.message, {
-      operation: 'open',
-      code: e.code,
-      path: filepath
-    })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, fd, cb)
+  return result
 }
 
 function openSync(filepath, flags = 'r', mode = 0o666) {
@@ -166,21 +238,64 @@ function openSync(filepath, flags = 'r', mode = 0o666) {
   }
 }
 
-async function close(fd, cb) {
-  const req = FileRequest.borrow()
+async function tryOpen(filepath, flags = 'r', mode = 0o666, cb) {
+  if (typeof flags === 'function') {
+    cb = flags
+    flags = 'r'
+    mode = 0o666
+  } else if (typeof mode === 'function') {
+    cb = mode
+    mode = 0o666
+  }
 
-  let err = null
+  if (typeof flags === 'string') flags = toFlags(flags)
+  if (typeof mode === 'string') mode = toMode(mode)
+
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow().probe()
+
+  let status
   try {
-    binding.close(req.handle, fd)
+    binding.open(req.handle, filepath, flags, mode)
 
-    await req
-  } catch (e) {
-    err = new FileError(e.message, { operation: 'close', code: e.code, fd })
+    status = await req
   } finally {
     req.return()
   }
 
-  return done(err, cb)
+  return done(null, status, cb)
+}
+
+function tryOpenSync(filepath, flags = 'r', mode = 0o666) {
+  if (typeof flags === 'string') flags = toFlags(flags)
+  if (typeof mode === 'string') mode = toMode(mode)
+
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow().probe()
+
+  try {
+    binding.openSync(req.handle, filepath, flags, mode)
+
+    return binding.requestResultStatus(req.handle)
+  } finally {
+    req.return()
+  }
+}
+
+function close(fd, cb) {
+  const req = FileRequest.borrow()
+
+  const result = req.complete('close', null, fd, null, cb)
+
+  try {
+    binding.close(req.handle, fd)
+  } catch (e) {
+    req._onresult(e, 0)
+  }
+
+  return result
 }
 
 function closeSync(fd) {
@@ -195,7 +310,7 @@ function closeSync(fd) {
   }
 }
 
-async function access(filepath, mode = constants.F_OK, cb) {
+function access(filepath, mode = constants.F_OK, cb) {
   if (typeof mode === 'function') {
     cb = mode
     mode = constants.F_OK
@@ -205,22 +320,15 @@ async function access(filepath, mode = constants.F_OK, cb) {
 
   const req = FileRequest.borrow()
 
-  let err = null
+  const result = req.complete('access', filepath, -1, null, cb)
+
   try {
     binding.access(req.handle, filepath, mode)
-
-    await req
   } catch (e) {
-    err = new FileError(e.message, {
-      operation: 'access',
-      code: e.code,
-      path: filepath
-    })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, cb)
+  return result
 }
 
 function accessSync(filepath, mode = constants.F_OK) {
@@ -241,20 +349,72 @@ function accessSync(filepath, mode = constants.F_OK) {
   }
 }
 
-async function exists(filepath, cb) {
+async function exists(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
   let ok = true
-  try {
-    await access(filepath)
-  } catch {
-    ok = false
+
+  if (opts.cache) {
+    try {
+      await stat(filepath, opts)
+    } catch {
+      ok = false
+    }
+  } else {
+    ok = (await tryAccess(filepath)) === 0
   }
 
   return done(null, ok, cb)
 }
 
-function existsSync(filepath) {
+async function tryAccess(filepath, mode = constants.F_OK, cb) {
+  if (typeof mode === 'function') {
+    cb = mode
+    mode = constants.F_OK
+  }
+
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow().probe()
+
+  let status
+  try {
+    binding.access(req.handle, filepath, mode)
+
+    status = await req
+  } finally {
+    req.return()
+  }
+
+  return done(null, status, cb)
+}
+
+function tryAccessSync(filepath, mode = constants.F_OK) {
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow().probe()
+
+  try {
+    binding.accessSync(req.handle, filepath, mode)
+
+    return binding.requestResultStatus(req.handle)
+  } finally {
+    req.return()
+  }
+}
+
+function existsSync(filepath, opts) {
+  if (!opts) opts = {}
+
+  if (!opts.cache) return tryAccessSync(filepath) === 0
+
   try {
-    accessSync(filepath)
+    statSync(filepath, opts)
   } catch {
     return false
   }
@@ -262,7 +422,7 @@ function existsSync(filepath) {
   return true
 }
 
-async function read(fd, buffer, offset = 0, len = buffer.byteLength - offset, pos = -1, cb) {
+function read(fd, buffer, offset = 0, len = buffer.byteLength - offset, pos = -1, cb) {
   if (typeof offset === 'function') {
     cb = offset
     offset = 0
@@ -281,21 +441,17 @@ async function read(fd, buffer, offset = 0, len = buffer.byteLength - offset, po
 
   const req = FileRequest.borrow()
 
-  let bytes
-  let err = null
+  const result = req.complete('read', null, fd, toStatus, cb)
+
   try {
     binding.read(req.handle, fd, buffer, offset, len, pos)
 
     req.retain(buffer)
-
-    bytes = await req
   } catch (e) {
-    err = new FileError(e.message, { operation: 'read', code: e.code, fd })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, bytes, cb)
+  return result
 }
 
 function readSync(fd, buffer, offset = 0, len = buffer.byteLength - offset, pos = -1) {
@@ -351,7 +507,96 @@ function readvSync(fd, buffers, pos = -1) {
   }
 }
 
-async function write(fd, data, offset, len, pos = -1, cb) {
+async function readParallel(fd, buffer, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const { position = 0, length = buffer.byteLength, concurrency = 4 } = opts
+
+  // Chunks are kept page aligned so that every pread starts on a page
+  // boundary of the file, provided the initial position is aligned.
+  const chunkSize = Math.max(4096, Math.ceil((opts.chunkSize || 4 * 1024 * 1024) / 4096) * 4096)
+
+  const chunks = Math.ceil(length / chunkSize)
+
+  let next = 0
+  let bytes = 0
+  let err = null
+
+  async function worker() {
+    while (err === null && next < chunks) {
+      const start = next++ * chunkSize
+      const end = Math.min(start + chunkSize, length)
+
+      let len = 0
+
+      while (start + len < end) {
+        const r = await read(fd, buffer, start + len, end - start - len, position + start + len)
+        if (r === 0) break
+        len += r
+      }
+
+      bytes += len
+    }
+  }
+
+  const workers = []
+
+  for (let i = 0, n = Math.min(Math.max(concurrency, 1), chunks); i < n; i++) {
+    workers.push(
+      worker().catch((e) => {
+        if (err === null) err = e
+      })
+    )
+  }
+
+  await Promise.all(workers)
+
+  return done(err, bytes, cb)
+}
+
+async function readMany(fd, ops, cb) {
+  const [buffers, positions] = toManyOperations(ops)
+  const bytes = new Int32Array(ops.length)
+
+  const req = FileRequest.borrow()
+
+  let err = null
+  try {
+    req.retain([binding.readMany(req.handle, fd, buffers, positions, bytes), buffers, bytes])
+
+    await req
+  } catch (e) {
+    err = new FileError(e.message, { operation: 'readMany', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+
+  return done(err, err ? undefined : Array.from(bytes), cb)
+}
+
+function readManySync(fd, ops) {
+  const [buffers, positions] = toManyOperations(ops)
+  const bytes = new Int32Array(ops.length)
+
+  const req = FileRequest.borrow()
+
+  try {
+    binding.readManySync(req.handle, fd, buffers, positions, bytes)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'readMany', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+
+  return Array.from(bytes)
+}
+
+function write(fd, data, offset, len, pos = -1, cb) {
   if (typeof data === 'string') {
     let encoding = len
     cb = pos
@@ -371,6 +616,10 @@ async function write(fd, data, offset, len, pos = -1, cb) {
       pos = -1
     }
 
+    if (typeof pos !== 'number') pos = -1
+
+    if (isUtf8(encoding || 'utf8')) return writeUtf8(fd, data, pos, cb)
+
     data = Buffer.from(data, encoding)
     offset = 0
     len = data.byteLength
@@ -394,21 +643,17 @@ async function write(fd, data, offset, len, pos = -1, cb) {
 
   const req = FileRequest.borrow()
 
-  let bytes
-  let err = null
+  const result = req.complete('write', null, fd, toStatus, cb)
+
   try {
     binding.write(req.handle, fd, data, offset, len, pos)
 
     req.retain(data)
-
-    bytes = await req
   } catch (e) {
-    err = new FileError(e.message, { operation: 'write', code: e.code, fd })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, bytes, cb)
+  return result
 }
 
 function writeSync(fd, data, offset, len, pos = -1) {
@@ -421,6 +666,10 @@ function writeSync(fd, data, offset, len, pos = -1) {
       pos = -1
     }
 
+    if (typeof pos !== 'number') pos = -1
+
+    if (isUtf8(encoding || 'utf8')) return writeUtf8Sync(fd, data, pos)
+
     data = Buffer.from(data, encoding)
     offset = 0
     len = data.byteLength
@@ -441,6 +690,37 @@ function writeSync(fd, data, offset, len, pos = -1) {
   }
 }
 
+// Writes all of a string, encoded as UTF-8 straight into native memory.
+async function writeUtf8(fd, data, pos, cb) {
+  const req = FileRequest.borrow()
+
+  let bytes
+  let err = null
+  try {
+    req.retain(binding.writeUtf8(req.handle, fd, data, pos))
+
+    bytes = await req
+  } catch (e) {
+    err = new FileError(e.message, { operation: 'write', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+
+  return done(err, bytes, cb)
+}
+
+function writeUtf8Sync(fd, data, pos) {
+  const req = FileRequest.borrow()
+
+  try {
+    return binding.writeUtf8Sync(req.handle, fd, data, pos)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'write', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
 async function writev(fd, buffers, pos = -1, cb) {
   if (typeof pos === 'function') {
     cb = pos
@@ -482,100 +762,254 @@ function writevSync(fd, buffers, pos = -1) {
   }
 }
 
-async function stat(filepath, cb) {
-  filepath = toNamespacedPath(filepath)
+async function writeMany(fd, ops, cb) {
+  const [buffers, positions] = toManyOperations(ops)
+  const bytes = new Int32Array(ops.length)
 
   const req = FileRequest.borrow()
 
-  let st
   let err = null
   try {
-    binding.stat(req.handle, filepath)
+    req.retain([binding.writeMany(req.handle, fd, buffers, positions, bytes), buffers, bytes])
 
     await req
-
-    st = new Stats(...binding.requestResultStat(req.handle))
   } catch (e) {
-    err = new FileError(e.message, { operation: 'stat', code: e.code, path: filepath })
+    err = new FileError(e.message, { operation: 'writeMany', code: e.code, fd })
   } finally {
     req.return()
   }
 
-  return done(err, st, cb)
+  return done(err, err ? undefined : Array.from(bytes), cb)
 }
 
-function statSync(filepath) {
-  filepath = toNamespacedPath(filepath)
+function writeManySync(fd, ops) {
+  const [buffers, positions] = toManyOperations(ops)
+  const bytes = new Int32Array(ops.length)
 
   const req = FileRequest.borrow()
 
   try {
-    binding.statSync(req.handle, filepath)
-
-    return new Stats(...binding.requestResultStat(req.handle))
+    binding.writeManySync(req.handle, fd, buffers, positions, bytes)
   } catch (e) {
-    throw new FileError(e.message, { operation: 'stat', code: e.code, path: filepath })
+    throw new FileError(e.message, { operation: 'writeMany', code: e.code, fd })
   } finally {
     req.return()
   }
+
+  return Array.from(bytes)
 }
 
-async function lstat(filepath, cb) {
+function stat(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const { cache = null } = opts
+
   filepath = toNamespacedPath(filepath)
 
+  if (cache !== null) return statCached(filepath, cache, cb)
+
   const req = FileRequest.borrow()
 
+  const result = req.complete('stat', filepath, -1, toStats, cb)
+
+  try {
+    binding.stat(req.handle, filepath)
+  } catch (e) {
+    req._onresult(e, 0)
+  }
+
+  return result
+}
+
+async function statCached(filepath, cache, cb) {
+  const entry = cache._get('stat', filepath)
+
+  if (entry !== null) return done(entry.error, entry.value, cb)
+
   let st
   let err = null
   try {
-    binding.lstat(req.handle, filepath)
+    st = await stat(filepath)
+  } catch (e) {
+    err = e
+  }
 
-    await req
+  cache._set('stat', filepath, err, st)
+
+  return done(err, st, cb)
+}
+
+function statSync(filepath, opts) {
+  if (!opts) opts = {}
+
+  const { cache = null } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  if (cache !== null) {
+    const entry = cache._get('stat', filepath)
+
+    if (entry !== null) {
+      if (entry.error) throw entry.error
+
+      return entry.value
+    }
+  }
+
+  const req = FileRequest.borrow()
+
+  let st
+  let err = null
+  try {
+    binding.statSync(req.handle, filepath)
 
     st = new Stats(...binding.requestResultStat(req.handle))
   } catch (e) {
-    err = new FileError(e.message, { operation: 'lstat', code: e.code, path: filepath })
+    err = new FileError(e.message, { operation: 'stat', code: e.code, path: filepath })
   } finally {
     req.return()
   }
 
-  return done(err, st, cb)
+  if (cache !== null) cache._set('stat', filepath, err, st)
+
+  if (err) throw err
+
+  return st
 }
 
-function lstatSync(filepath) {
+async function tryStat(filepath, cb) {
   filepath = toNamespacedPath(filepath)
 
-  const req = FileRequest.borrow()
+  const req = FileRequest.borrow().probe()
 
+  let st = null
   try {
-    binding.lstatSync(req.handle, filepath)
+    binding.stat(req.handle, filepath)
+
+    if ((await req) === 0) st = new Stats(...binding.requestResultStat(req.handle))
+  } finally {
+    req.return()
+  }
+
+  return done(null, st, cb)
+}
+
+function tryStatSync(filepath) {
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow().probe()
+
+  try {
+    binding.statSync(req.handle, filepath)
+
+    if (binding.requestResultStatus(req.handle) !== 0) return null
 
     return new Stats(...binding.requestResultStat(req.handle))
-  } catch (e) {
-    throw new FileError(e.message, { operation: 'lstat', code: e.code, path: filepath })
   } finally {
     req.return()
   }
 }
 
-async function fstat(fd, cb) {
+function lstat(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const { cache = null } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  if (cache !== null) return lstatCached(filepath, cache, cb)
+
   const req = FileRequest.borrow()
 
+  const result = req.complete('lstat', filepath, -1, toStats, cb)
+
+  try {
+    binding.lstat(req.handle, filepath)
+  } catch (e) {
+    req._onresult(e, 0)
+  }
+
+  return result
+}
+
+async function lstatCached(filepath, cache, cb) {
+  const entry = cache._get('lstat', filepath)
+
+  if (entry !== null) return done(entry.error, entry.value, cb)
+
   let st
   let err = null
   try {
-    binding.fstat(req.handle, fd)
+    st = await lstat(filepath)
+  } catch (e) {
+    err = e
+  }
 
-    await req
+  cache._set('lstat', filepath, err, st)
+
+  return done(err, st, cb)
+}
+
+function lstatSync(filepath, opts) {
+  if (!opts) opts = {}
+
+  const { cache = null } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  if (cache !== null) {
+    const entry = cache._get('lstat', filepath)
+
+    if (entry !== null) {
+      if (entry.error) throw entry.error
+
+      return entry.value
+    }
+  }
+
+  const req = FileRequest.borrow()
+
+  let st
+  let err = null
+  try {
+    binding.lstatSync(req.handle, filepath)
 
     st = new Stats(...binding.requestResultStat(req.handle))
   } catch (e) {
-    err = new FileError(e.message, { operation: 'fstat', code: e.code, fd })
+    err = new FileError(e.message, { operation: 'lstat', code: e.code, path: filepath })
   } finally {
     req.return()
   }
 
-  return done(err, st, cb)
+  if (cache !== null) cache._set('lstat', filepath, err, st)
+
+  if (err) throw err
+
+  return st
+}
+
+function fstat(fd, cb) {
+  const req = FileRequest.borrow()
+
+  const result = req.complete('fstat', null, fd, toStats, cb)
+
+  try {
+    binding.fstat(req.handle, fd)
+  } catch (e) {
+    req._onresult(e, 0)
+  }
+
+  return result
 }
 
 function fstatSync(fd) {
@@ -630,7 +1064,7 @@ function statfsSync(filepath) {
   }
 }
 
-async function ftruncate(fd, len = 0, cb) {
+function ftruncate(fd, len = 0, cb) {
   if (typeof len === 'function') {
     cb = len
     len = 0
@@ -640,13 +1074,48 @@ async function ftruncate(fd, len = 0, cb) {
 
   const req = FileRequest.borrow()
 
-  let err = null
+  const result = req.complete('ftruncate', null, fd, null, cb)
+
   try {
     binding.ftruncate(req.handle, fd, len)
+  } catch (e) {
+    req._onresult(e, 0)
+  }
+
+  return result
+}
+
+function ftruncateSync(fd, len = 0) {
+  if (typeof len !== 'number') len = 0
+
+  const req = FileRequest.borrow()
+
+  try {
+    binding.ftruncateSync(req.handle, fd, len)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'ftruncate', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+async function fallocate(fd, offset, len, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const req = FileRequest.borrow()
+
+  let err = null
+  try {
+    req.retain(binding.fallocate(req.handle, fd, offset, len, toFallocateMode(opts)))
 
     await req
   } catch (e) {
-    err = new FileError(e.message, { operation: 'ftruncate', code: e.code, fd })
+    err = new FileError(e.message, { operation: 'fallocate', code: e.code, fd })
   } finally {
     req.return()
   }
@@ -654,15 +1123,99 @@ async function ftruncate(fd, len = 0, cb) {
   return done(err, cb)
 }
 
-function ftruncateSync(fd, len = 0) {
-  if (typeof len !== 'number') len = 0
+function fallocateSync(fd, offset, len, opts) {
+  if (!opts) opts = {}
 
   const req = FileRequest.borrow()
 
   try {
-    binding.ftruncateSync(req.handle, fd, len)
+    binding.fallocateSync(req.handle, fd, offset, len, toFallocateMode(opts))
   } catch (e) {
-    throw new FileError(e.message, { operation: 'ftruncate', code: e.code, fd })
+    throw new FileError(e.message, { operation: 'fallocate', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+async function writeback(fd, offset, len, mode) {
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain(binding.writeback(req.handle, fd, offset, len, mode))
+
+    await req
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'writeback', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+function writebackSync(fd, offset, len, mode) {
+  const req = FileRequest.borrow()
+
+  try {
+    binding.writebackSync(req.handle, fd, offset, len, mode)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'writeback', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+async function* dataRanges(fd, offset = 0) {
+  const ranges = new Float64Array(2 * 64)
+
+  while (true) {
+    const len = await readDataRanges(fd, offset, ranges)
+
+    for (let i = 0; i < len; i++) {
+      yield { offset: ranges[i * 2], length: ranges[i * 2 + 1] }
+    }
+
+    if (len < ranges.length / 2) break
+
+    offset = ranges[len * 2 - 2] + ranges[len * 2 - 1]
+  }
+}
+
+function* dataRangesSync(fd, offset = 0) {
+  const ranges = new Float64Array(2 * 64)
+
+  while (true) {
+    const len = readDataRangesSync(fd, offset, ranges)
+
+    for (let i = 0; i < len; i++) {
+      yield { offset: ranges[i * 2], length: ranges[i * 2 + 1] }
+    }
+
+    if (len < ranges.length / 2) break
+
+    offset = ranges[len * 2 - 2] + ranges[len * 2 - 1]
+  }
+}
+
+async function readDataRanges(fd, offset, ranges) {
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain([binding.dataRanges(req.handle, fd, offset, ranges), ranges])
+
+    return await req
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'dataRanges', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+function readDataRangesSync(fd, offset, ranges) {
+  const req = FileRequest.borrow()
+
+  try {
+    return binding.dataRangesSync(req.handle, fd, offset, ranges)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'dataRanges', code: e.code, fd })
   } finally {
     req.return()
   }
@@ -1298,27 +1851,20 @@ function rmSync(filepath, opts) {
   }
 }
 
-async function unlink(filepath, cb) {
+function unlink(filepath, cb) {
   filepath = toNamespacedPath(filepath)
 
   const req = FileRequest.borrow()
 
-  let err = null
+  const result = req.complete('unlink', filepath, -1, null, cb)
+
   try {
     binding.unlink(req.handle, filepath)
-
-    await req
   } catch (e) {
-    err = new FileError(e.message, {
-      operation: 'unlink',
-      code: e.code,
-      path: filepath
-    })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, cb)
+  return result
 }
 
 function unlinkSync(filepath) {
@@ -1390,6 +1936,13 @@ async function copyFile(src, dst, mode = 0, cb) {
     mode = 0
   }
 
+  let sparse = false
+
+  if (typeof mode === 'object' && mode !== null) {
+    sparse = mode.sparse === true
+    mode = mode.mode || 0
+  }
+
   src = toNamespacedPath(src)
   dst = toNamespacedPath(dst)
 
@@ -1397,7 +1950,8 @@ async function copyFile(src, dst, mode = 0, cb) {
 
   let err = null
   try {
-    binding.copyfile(req.handle, src, dst, mode)
+    if (sparse) req.retain(binding.copyfileSparse(req.handle, src, dst, mode))
+    else binding.copyfile(req.handle, src, dst, mode)
 
     await req
   } catch (e) {
@@ -1415,13 +1969,21 @@ async function copyFile(src, dst, mode = 0, cb) {
 }
 
 function copyFileSync(src, dst, mode = 0) {
+  let sparse = false
+
+  if (typeof mode === 'object' && mode !== null) {
+    sparse = mode.sparse === true
+    mode = mode.mode || 0
+  }
+
   src = toNamespacedPath(src)
   dst = toNamespacedPath(dst)
 
   const req = FileRequest.borrow()
 
   try {
-    binding.copyfileSync(req.handle, src, dst, mode)
+    if (sparse) binding.copyfileSparseSync(req.handle, src, dst, mode)
+    else binding.copyfileSync(req.handle, src, dst, mode)
   } catch (e) {
     throw new FileError(e.message, {
       operation: 'copyfile',
@@ -1467,7 +2029,7 @@ async function cp(src, dst, opts, cb) {
         await cp(path.join(src, name), path.join(dst, name), opts)
       }
     } else if (st.isFile()) {
-      await copyFile(src, dst)
+      await copyFile(src, dst, { sparse: opts.sparse === true })
       await chmod(dst, st.mode)
     }
   } catch (e) {
@@ -1501,7 +2063,7 @@ function cpSync(src, dst, opts = {}) {
       cpSync(path.join(src, name), path.join(dst, name), opts)
     }
   } else if (st.isFile()) {
-    copyFileSync(src, dst)
+    copyFileSync(src, dst, { sparse: opts.sparse === true })
     chmodSync(dst, st.mode)
   }
 }
@@ -1515,64 +2077,195 @@ async function realpath(filepath, opts, cb) {
   if (typeof opts === 'string') opts = { encoding: opts }
   else if (!opts) opts = {}
 
-  const { encoding = 'utf8' } = opts
+  const { encoding = 'utf8', cache = null } = opts
 
   filepath = toNamespacedPath(filepath)
 
-  const req = FileRequest.borrow()
-
   let res
   let err = null
   try {
-    binding.realpath(req.handle, filepath)
+    if (cache !== null && !hasParentSegment(filepath)) {
+      res = encodePath(await realpathCached(path.resolve(filepath), cache), encoding)
+    } else {
+      res = await realpathUncached(filepath, encoding)
+    }
+  } catch (e) {
+    err = e
+  }
 
-    await req
+  return done(err, res, cb)
+}
 
-    res = Buffer.from(binding.requestResultString(req.handle))
+function realpathSync(filepath, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
 
-    if (encoding !== 'buffer') res = res.toString(encoding)
+  const { encoding = 'utf8', cache = null } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  if (cache !== null && !hasParentSegment(filepath)) {
+    return encodePath(realpathCachedSync(path.resolve(filepath), cache), encoding)
+  }
+
+  return realpathUncachedSync(filepath, encoding)
+}
+
+async function realpathUncached(filepath, encoding, reported = filepath) {
+  const req = FileRequest.borrow()
+
+  try {
+    binding.realpath(req.handle, filepath)
+
+    await req
+
+    return requestResultString(req.handle, encoding)
   } catch (e) {
-    err = new FileError(e.message, {
+    throw new FileError(e.message, {
       operation: 'realpath',
       code: e.code,
-      path: filepath
+      path: reported
     })
   } finally {
     req.return()
   }
-
-  return done(err, res, cb)
 }
 
-function realpathSync(filepath, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
-
-  const { encoding = 'utf8' } = opts
-
-  filepath = toNamespacedPath(filepath)
-
+function realpathUncachedSync(filepath, encoding, reported = filepath) {
   const req = FileRequest.borrow()
 
   try {
     binding.realpathSync(req.handle, filepath)
 
-    let res = Buffer.from(binding.requestResultString(req.handle))
-
-    if (encoding !== 'buffer') res = res.toString(encoding)
-
-    return res
+    return requestResultString(req.handle, encoding)
   } catch (e) {
     throw new FileError(e.message, {
       operation: 'realpath',
       code: e.code,
-      path: filepath
+      path: reported
     })
   } finally {
     req.return()
   }
 }
 
+// The number of symbolic links followed before resolution fails, as in Linux.
+const REALPATH_MAX_LINKS = 40
+
+// Resolve a path a component at a time, caching the real path of every prefix
+// so that lookups sharing a directory only resolve the components below it.
+// Each component costs an lstat() and symbolic links an additional readlink().
+// If a component fails to resolve, the path is resolved again in full so that
+// errors match those of `fs.realpath()`. Windows paths are always resolved in
+// full as their components don't map onto symbolic links alone.
+async function realpathCached(filepath, cache, links = 0) {
+  let entry = cache._get('realpath', filepath)
+
+  if (entry === null) {
+    const parent = path.dirname(filepath)
+
+    let value = null
+
+    if (!isWindows && parent !== filepath) {
+      try {
+        const dir = await realpathCached(parent, cache, links)
+        const target = path.join(dir, path.basename(filepath))
+
+        if ((await lstat(target)).isSymbolicLink()) {
+          if (links < REALPATH_MAX_LINKS) {
+            const link = path.resolve(dir, await readlink(target))
+
+            value = await realpathCached(link, cache, links + 1)
+          }
+        } else {
+          value = target
+        }
+      } catch {
+        value = null
+      }
+    }
+
+    if (value === null) entry = await realpathEntry(filepath, filepath, cache)
+    else {
+      cache._set('realpath', filepath, null, value)
+
+      entry = { error: null, value }
+    }
+  }
+
+  if (entry.error) throw entry.error
+
+  return entry.value
+}
+
+function realpathCachedSync(filepath, cache, links = 0) {
+  let entry = cache._get('realpath', filepath)
+
+  if (entry === null) {
+    const parent = path.dirname(filepath)
+
+    let value = null
+
+    if (!isWindows && parent !== filepath) {
+      try {
+        const dir = realpathCachedSync(parent, cache, links)
+        const target = path.join(dir, path.basename(filepath))
+
+        if (lstatSync(target).isSymbolicLink()) {
+          if (links < REALPATH_MAX_LINKS) {
+            const link = path.resolve(dir, readlinkSync(target))
+
+            value = realpathCachedSync(link, cache, links + 1)
+          }
+        } else {
+          value = target
+        }
+      } catch {
+        value = null
+      }
+    }
+
+    if (value === null) entry = realpathEntrySync(filepath, filepath, cache)
+    else {
+      cache._set('realpath', filepath, null, value)
+
+      entry = { error: null, value }
+    }
+  }
+
+  if (entry.error) throw entry.error
+
+  return entry.value
+}
+
+async function realpathEntry(filepath, target, cache) {
+  let value = null
+  let error = null
+  try {
+    value = await realpathUncached(target, 'utf8', filepath)
+  } catch (e) {
+    error = e
+  }
+
+  cache._set('realpath', filepath, error, value)
+
+  return { error, value }
+}
+
+function realpathEntrySync(filepath, target, cache) {
+  let value = null
+  let error = null
+  try {
+    value = realpathUncachedSync(target, 'utf8', filepath)
+  } catch (e) {
+    error = e
+  }
+
+  cache._set('realpath', filepath, error, value)
+
+  return { error, value }
+}
+
 async function readlink(filepath, opts, cb) {
   if (typeof opts === 'function') {
     cb = opts
@@ -1595,9 +2288,7 @@ async function readlink(filepath, opts, cb) {
 
     await req
 
-    res = Buffer.from(binding.requestResultString(req.handle))
-
-    if (encoding !== 'buffer') res = res.toString(encoding)
+    res = requestResultString(req.handle, encoding)
   } catch (e) {
     err = new FileError(e.message, {
       operation: 'readlink',
@@ -1624,11 +2315,7 @@ function readlinkSync(filepath, opts) {
   try {
     binding.readlinkSync(req.handle, filepath)
 
-    let res = Buffer.from(binding.requestResultString(req.handle))
-
-    if (encoding !== 'buffer') res = res.toString(encoding)
-
-    return res
+    return requestResultString(req.handle, encoding)
   } catch (e) {
     throw new FileError(e.message, {
       operation: 'readlink',
@@ -1640,21 +2327,18 @@ function readlinkSync(filepath, opts) {
   }
 }
 
-async function fsync(fd, cb) {
+function fsync(fd, cb) {
   const req = FileRequest.borrow()
 
-  let err = null
+  const result = req.complete('fsync', null, fd, null, cb)
+
   try {
     binding.fsync(req.handle, fd)
-
-    await req
   } catch (e) {
-    err = new FileError(e.message, { operation: 'fsync', code: e.code, fd })
-  } finally {
-    req.return()
+    req._onresult(e, 0)
   }
 
-  return done(err, cb)
+  return result
 }
 
 function fsyncSync(fd) {
@@ -1698,1000 +2382,3590 @@ function fdatasyncSync(fd) {
   }
 }
 
-function normalizeSymlinkTarget(target, type, filepath) {
-  if (isWindows) {
-    if (type === constants.UV_FS_SYMLINK_JUNCTION) target = path.resolve(filepath, '..', target)
+const hashAlgorithms = {
+  sha256: binding.HASH_SHA256,
+  blake2b512: binding.HASH_BLAKE2B512,
+  crc32c: binding.HASH_CRC32C
+}
 
-    if (path.isAbsolute(target)) return path.toNamespacedPath(target)
+const hashDigestLengths = {
+  sha256: 32,
+  blake2b512: 64,
+  crc32c: 4
+}
 
-    return target.replace(/\//g, path.sep)
+async function hashFile(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
   }
 
-  return target
-}
+  if (typeof opts === 'string') opts = { algorithm: opts }
+  else if (!opts) opts = {}
 
-async function symlink(target, filepath, type, cb) {
-  if (typeof type === 'function') {
-    cb = type
-    type = null
-  }
+  const { algorithm = 'sha256', offset = 0, length = -1, encoding = 'buffer' } = opts
 
-  filepath = toNamespacedPath(filepath)
+  let fd = -1
 
-  if (typeof type === 'string') {
-    switch (type) {
-      case 'dir':
-        type = constants.UV_FS_SYMLINK_DIR
-        break
-      case 'junction':
-        type = constants.UV_FS_SYMLINK_JUNCTION
-        break
-      case 'file':
-      default:
-        type = 0
-        break
-    }
-  } else if (typeof type !== 'number') {
-    if (isWindows) {
-      target = path.resolve(filepath, '..', target)
+  if (typeof filepath === 'number') fd = filepath
+  else filepath = toNamespacedPath(filepath)
 
-      try {
-        type = (await stat(target)).isDirectory()
-          ? constants.UV_FS_SYMLINK_DIR
-          : constants.UV_FS_SYMLINK_JUNCTION
-      } catch {
-        type = 0
-      }
-    } else {
-      type = 0
-    }
-  }
+  const type = hashAlgorithms[algorithm]
 
-  target = normalizeSymlinkTarget(target, type, filepath)
+  if (type === undefined) {
+    return fail(
+      new FileError(`unsupported hash algorithm ${JSON.stringify(algorithm)}`, {
+        operation: 'hashFile',
+        code: 'EINVAL',
+        path: fd === -1 ? filepath : null,
+        fd
+      }),
+      cb
+    )
+  }
 
   const req = FileRequest.borrow()
 
+  let digest
   let err = null
   try {
-    binding.symlink(req.handle, target, filepath, type)
+    req.retain(binding.hashFile(req.handle, fd, fd === -1 ? filepath : '', type, offset, length))
 
     await req
+
+    digest = Buffer.from(binding.requestResultDigest(req.handle))
+
+    if (encoding !== 'buffer') digest = digest.toString(encoding)
   } catch (e) {
     err = new FileError(e.message, {
-      operation: 'symlink',
+      operation: 'hashFile',
       code: e.code,
-      path: target,
-      destination: filepath
+      path: fd === -1 ? filepath : null,
+      fd
     })
   } finally {
     req.return()
   }
 
-  return done(err, cb)
+  return done(err, digest, cb)
 }
 
-function symlinkSync(target, filepath, type) {
-  filepath = toNamespacedPath(filepath)
+function hashFileSync(filepath, opts) {
+  if (typeof opts === 'string') opts = { algorithm: opts }
+  else if (!opts) opts = {}
 
-  if (typeof type === 'string') {
-    switch (type) {
-      case 'dir':
-        type = constants.UV_FS_SYMLINK_DIR
-        break
-      case 'junction':
-        type = constants.UV_FS_SYMLINK_JUNCTION
-        break
-      case 'file':
-      default:
-        type = 0
-        break
-    }
-  } else if (typeof type !== 'number') {
-    if (isWindows) {
-      target = path.resolve(filepath, '..', target)
+  const { algorithm = 'sha256', offset = 0, length = -1, encoding = 'buffer' } = opts
 
-      try {
-        type = statSync(target).isDirectory()
-          ? constants.UV_FS_SYMLINK_DIR
-          : constants.UV_FS_SYMLINK_JUNCTION
-      } catch {
-        type = 0
-      }
-    } else {
-      type = 0
-    }
-  }
+  let fd = -1
 
-  target = normalizeSymlinkTarget(target, type, filepath)
+  if (typeof filepath === 'number') fd = filepath
+  else filepath = toNamespacedPath(filepath)
+
+  const type = hashAlgorithms[algorithm]
+
+  if (type === undefined) {
+    throw new FileError(`unsupported hash algorithm ${JSON.stringify(algorithm)}`, {
+      operation: 'hashFile',
+      code: 'EINVAL',
+      path: fd === -1 ? filepath : null,
+      fd
+    })
+  }
 
   const req = FileRequest.borrow()
 
   try {
-    binding.symlinkSync(req.handle, target, filepath, type)
+    req.retain(
+      binding.hashFileSync(req.handle, fd, fd === -1 ? filepath : '', type, offset, length)
+    )
+
+    let digest = Buffer.from(binding.requestResultDigest(req.handle))
+
+    if (encoding !== 'buffer') digest = digest.toString(encoding)
+
+    return digest
   } catch (e) {
     throw new FileError(e.message, {
-      operation: 'symlink',
+      operation: 'hashFile',
       code: e.code,
-      path: target,
-      destination: filepath
+      path: fd === -1 ? filepath : null,
+      fd
     })
   } finally {
     req.return()
   }
 }
 
-async function opendir(filepath, opts, cb) {
+// Snapshots start with a header of the magic bytes `BFSN`, the format version,
+// the hash algorithm, the digest length, and flags, followed by the record of
+// the root. Records consist of the entry kind, name, mode, size, mtime, and
+// inode, followed by the digest of the contents for files when requested, and
+// for directories by their Merkle hash and the length of the records of their
+// subtree, which follow.
+const SNAPSHOT_VERSION = 1
+const SNAPSHOT_CONTENTS = 1
+
+const snapshotKinds = {
+  FILE: 1,
+  DIRECTORY: 2,
+  SYMLINK: 3,
+  OTHER: 4
+}
+
+async function snapshot(root, opts, cb) {
   if (typeof opts === 'function') {
     cb = opts
     opts = {}
   }
 
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+  if (!opts) opts = {}
 
-  filepath = toNamespacedPath(filepath)
+  const { algorithm = 'sha256', contents = false } = opts
 
-  const req = FileRequest.borrow()
+  root = toNamespacedPath(root)
 
-  let dir
+  let result = null
   let err = null
   try {
-    binding.opendir(req.handle, filepath)
+    const header = toSnapshotHeader(algorithm, contents, root)
 
-    await req
+    const out = { records: [header], byteLength: header.byteLength }
 
-    dir = new Dir(filepath, binding.requestResultDir(req.handle), opts)
+    await snapshotEntry(root, '', await lstat(root), opts, out)
+
+    result = Buffer.concat(out.records, out.byteLength)
   } catch (e) {
-    err = new FileError(e.message, {
-      operation: 'opendir',
-      code: e.code,
-      path: filepath
-    })
-  } finally {
-    req.return()
+    err = e
   }
 
-  return done(err, dir, cb)
+  return done(err, result, cb)
 }
 
-function opendirSync(filepath, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function snapshotSync(root, opts = {}) {
+  const { algorithm = 'sha256', contents = false } = opts
 
-  filepath = toNamespacedPath(filepath)
+  root = toNamespacedPath(root)
 
-  const req = FileRequest.borrow()
+  const header = toSnapshotHeader(algorithm, contents, root)
 
-  try {
-    binding.opendirSync(req.handle, filepath)
+  const out = { records: [header], byteLength: header.byteLength }
 
-    return new Dir(filepath, binding.requestResultDir(req.handle), opts)
-  } catch (e) {
-    throw new FileError(e.message, {
-      operation: 'opendir',
-      code: e.code,
-      path: filepath
-    })
-  } finally {
-    req.return()
-  }
+  snapshotEntrySync(root, '', lstatSync(root), opts, out)
+
+  return Buffer.concat(out.records, out.byteLength)
 }
 
-async function readdir(filepath, opts, cb) {
-  if (typeof opts === 'function') {
-    cb = opts
-    opts = {}
+// Appends the record of the entry followed by those of its subtree to `out`,
+// returning the record of the entry.
+async function snapshotEntry(filepath, name, st, opts, out) {
+  const { algorithm = 'sha256', contents = false } = opts
+
+  if (!st.isDirectory()) {
+    const digest = contents && st.isFile() ? await hashFile(filepath, { algorithm }) : null
+
+    return appendSnapshotRecord(out, toSnapshotRecord(name, st, digest, 0))
   }
 
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+  let dirents
+  try {
+    dirents = (await readdir(filepath, { withFileTypes: true, withStats: true })).sort(
+      compareDirents
+    )
+  } catch (err) {
+    if (err.code !== 'ENOENT') throw err
 
-  const { withFileTypes = false, recursive = false } = opts
+    dirents = []
+  }
 
-  filepath = toNamespacedPath(filepath)
+  // The record of the directory depends on those of its children, so a slot is
+  // reserved for it and filled in once its subtree has been appended.
+  const index = out.records.push(null) - 1
+  const start = out.byteLength
 
-  const queue = [filepath]
-  let result = []
-  let err = null
-  try {
-    while (queue.length !== 0) {
-      const dir = await opendir(queue.pop())
+  const children = []
 
-      for await (const entry of dir) {
-        const entryPath = path.join(entry.parentPath, entry.name)
+  for (const dirent of dirents) {
+    const childPath = path.join(filepath, dirent.name)
 
-        if (withFileTypes) {
-          result.push(entry)
-        } else {
-          result.push(path.relative(filepath, entryPath))
-        }
+    let childSt = dirent.stats
 
-        if (recursive && entry.isDirectory()) queue.push(entryPath)
+    // Stat the entry again if it couldn't be stat'ed along with the directory,
+    // to report why.
+    if (childSt === null) {
+      try {
+        childSt = await lstat(childPath)
+      } catch (err) {
+        if (err.code === 'ENOENT') continue
+
+        throw err
       }
     }
-  } catch (e) {
-    result = []
-    err = e
+
+    children.push(await snapshotEntry(childPath, dirent.name, childSt, opts, out))
   }
 
-  return done(err, result, cb)
+  return finishSnapshotDirectory(out, index, start, name, st, children, algorithm)
 }
 
-function readdirSync(filepath, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function snapshotEntrySync(filepath, name, st, opts, out) {
+  const { algorithm = 'sha256', contents = false } = opts
 
-  const { withFileTypes = false, recursive = false } = opts
+  if (!st.isDirectory()) {
+    const digest = contents && st.isFile() ? hashFileSync(filepath, { algorithm }) : null
 
-  filepath = toNamespacedPath(filepath)
+    return appendSnapshotRecord(out, toSnapshotRecord(name, st, digest, 0))
+  }
 
-  const queue = [filepath]
-  const result = []
+  let dirents
+  try {
+    dirents = readdirSync(filepath, { withFileTypes: true, withStats: true }).sort(compareDirents)
+  } catch (err) {
+    if (err.code !== 'ENOENT') throw err
 
-  while (queue.length !== 0) {
-    const dir = opendirSync(queue.pop(), opts)
+    dirents = []
+  }
 
-    for (const entry of dir) {
-      const entryPath = path.join(entry.parentPath, entry.name)
+  // The record of the directory depends on those of its children, so a slot is
+  // reserved for it and filled in once its subtree has been appended.
+  const index = out.records.push(null) - 1
+  const start = out.byteLength
 
-      if (withFileTypes) {
-        result.push(entry)
-      } else {
-        result.push(path.relative(filepath, entryPath))
-      }
+  const children = []
 
-      if (recursive && entry.isDirectory()) queue.push(entryPath)
+  for (const dirent of dirents) {
+    const childPath = path.join(filepath, dirent.name)
+
+    let childSt = dirent.stats
+
+    if (childSt === null) {
+      try {
+        childSt = lstatSync(childPath)
+      } catch (err) {
+        if (err.code === 'ENOENT') continue
+
+        throw err
+      }
     }
+
+    children.push(snapshotEntrySync(childPath, dirent.name, childSt, opts, out))
   }
 
-  return result
+  return finishSnapshotDirectory(out, index, start, name, st, children, algorithm)
 }
 
-async function readFile(filepath, opts, cb) {
-  if (typeof opts === 'function') {
-    cb = opts
-    opts = {}
-  }
-
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function compareDirents(a, b) {
+  return a.name < b.name ? -1 : a.name > b.name ? 1 : 0
+}
 
-  const { encoding = 'buffer' } = opts
+function toSnapshotHeader(algorithm, contents, root) {
+  const type = hashAlgorithms[algorithm]
 
-  let fd = -1
-  let buffer = null
-  let err = null
-  try {
-    fd = await open(filepath, opts.flag || 'r')
+  if (type === undefined) {
+    throw new FileError(`unsupported hash algorithm ${JSON.stringify(algorithm)}`, {
+      operation: 'snapshot',
+      code: 'EINVAL',
+      path: root
+    })
+  }
 
-    const st = await fstat(fd)
+  const header = Buffer.from('BFSN\0\0\0\0')
 
-    let len = 0
+  header[4] = SNAPSHOT_VERSION
+  header[5] = type
+  header[6] = hashDigestLengths[algorithm]
+  header[7] = contents ? SNAPSHOT_CONTENTS : 0
 
-    if (st.size === 0) {
-      const buffers = []
+  return header
+}
 
-      while (true) {
-        buffer = Buffer.allocUnsafe(8192)
-        const r = await read(fd, buffer)
-        len += r
-        if (r === 0) break
-        buffers.push(buffer.subarray(0, r))
-      }
+function appendSnapshotRecord(out, record) {
+  out.records.push(record)
+  out.byteLength += record.byteLength
 
-      buffer = Buffer.concat(buffers)
-    } else {
-      buffer = Buffer.allocUnsafe(st.size)
+  return record
+}
 
-      while (true) {
-        const r = await read(fd, len ? buffer.subarray(len) : buffer)
-        len += r
-        if (r === 0 || len === buffer.byteLength) break
-      }
+// The Merkle hash of a directory covers the records of its children, which
+// in turn cover the hashes of their own subtrees.
+function finishSnapshotDirectory(out, index, start, name, st, children, algorithm) {
+  const digest = Buffer.from(binding.hash(hashAlgorithms[algorithm], Buffer.concat(children)))
 
-      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
-    }
+  const record = toSnapshotRecord(name, st, digest, out.byteLength - start)
 
-    if (encoding !== 'buffer') buffer = buffer.toString(encoding)
-  } catch (e) {
-    err = e
-  } finally {
-    if (fd !== -1) await close(fd)
-  }
+  out.records[index] = record
+  out.byteLength += record.byteLength
 
-  return done(err, buffer, cb)
+  return record
 }
 
-function readFileSync(filepath, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function toSnapshotRecord(name, st, digest, subtree) {
+  const kind = st.isFile()
+    ? snapshotKinds.FILE
+    : st.isDirectory()
+      ? snapshotKinds.DIRECTORY
+      : st.isSymbolicLink()
+        ? snapshotKinds.SYMLINK
+        : snapshotKinds.OTHER
 
-  const { encoding = 'buffer' } = opts
+  const directory = kind === snapshotKinds.DIRECTORY
 
-  let fd = -1
-  try {
-    fd = openSync(filepath, opts.flag || 'r')
+  name = Buffer.from(name)
 
-    const st = fstatSync(fd)
+  const record = Buffer.alloc(
+    31 + name.byteLength + (digest ? digest.byteLength : 0) + (directory ? 4 : 0)
+  )
 
-    let buffer
-    let len = 0
+  const view = new DataView(record.buffer, record.byteOffset, record.byteLength)
 
-    if (st.size === 0) {
-      const buffers = []
+  view.setUint8(0, kind)
+  view.setUint16(1, name.byteLength, true)
 
-      while (true) {
-        buffer = Buffer.allocUnsafe(8192)
-        const r = readSync(fd, buffer)
-        len += r
-        if (r === 0) break
-        buffers.push(buffer.subarray(0, r))
-      }
+  record.set(name, 3)
 
-      buffer = Buffer.concat(buffers)
-    } else {
-      buffer = Buffer.allocUnsafe(st.size)
+  let offset = 3 + name.byteLength
 
-      while (true) {
-        const r = readSync(fd, len ? buffer.subarray(len) : buffer)
-        len += r
-        if (r === 0 || len === buffer.byteLength) break
-      }
+  // The size and mtime of directories only reflect their children, which the
+  // Merkle hash already covers.
+  view.setUint32(offset, st.mode, true)
+  view.setFloat64(offset + 4, directory ? 0 : st.size, true)
+  view.setFloat64(offset + 12, directory ? 0 : st.mtimeMs, true)
+  view.setFloat64(offset + 20, st.ino, true)
 
-      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
-    }
+  offset += 28
 
-    if (encoding !== 'buffer') buffer = buffer.toString(encoding)
+  if (digest) {
+    record.set(digest, offset)
 
-    return buffer
-  } finally {
-    if (fd !== -1) closeSync(fd)
+    offset += digest.byteLength
   }
+
+  if (directory) view.setUint32(offset, subtree, true)
+
+  return record
 }
 
-async function writeFile(filepath, data, opts, cb) {
-  if (typeof opts === 'function') {
-    cb = opts
-    opts = {}
+function diff(a, b) {
+  if (!isSnapshot(a) || !isSnapshot(b)) {
+    throw new FileError('invalid snapshot', { operation: 'diff', code: 'EINVAL' })
   }
 
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+  if (a[5] !== b[5] || a[7] !== b[7]) {
+    throw new FileError('snapshots use different options', { operation: 'diff', code: 'EINVAL' })
+  }
 
-  if (typeof data === 'string') data = Buffer.from(data, opts.encoding)
+  const changes = []
 
-  let fd = -1
-  let len = 0
-  let err = null
-  try {
-    fd = await open(filepath, opts.flag || 'w', opts.mode || 0o666)
+  diffSnapshotEntry(
+    readSnapshotRecord(toSnapshotReader(a), 8),
+    readSnapshotRecord(toSnapshotReader(b), 8),
+    '',
+    changes
+  )
 
-    while (true) {
-      len += await write(fd, len ? data.subarray(len) : data)
-      if (len === data.byteLength) break
-    }
-  } catch (e) {
-    err = e
-  } finally {
-    if (fd !== -1) await close(fd)
-  }
+  return changes
+}
 
-  return done(err, len, cb)
+function isSnapshot(snapshot) {
+  return (
+    snapshot.byteLength >= 8 &&
+    snapshot.subarray(0, 4).equals(Buffer.from('BFSN')) &&
+    snapshot[4] === SNAPSHOT_VERSION
+  )
 }
 
-function writeFileSync(filepath, data, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function diffSnapshotEntry(a, b, name, changes) {
+  // Identical records, including the Merkle hashes of directories, mean
+  // identical subtrees, which are skipped without being read.
+  if (a.record.equals(b.record)) return
 
-  if (typeof data === 'string') data = Buffer.from(data, opts.encoding)
+  if (a.kind !== b.kind || a.kind !== snapshotKinds.DIRECTORY) {
+    changes.push({ type: 'change', path: name })
 
-  let fd = -1
-  try {
-    fd = openSync(filepath, opts.flag || 'w', opts.mode || 0o666)
+    return
+  }
 
-    let len = 0
+  if (a.mode !== b.mode || a.ino !== b.ino) changes.push({ type: 'change', path: name })
 
-    while (true) {
-      len += writeSync(fd, len ? data.subarray(len) : data)
-      if (len === data.byteLength) break
+  if (a.digest.equals(b.digest)) return
+
+  const childrenA = readSnapshotChildren(a)
+  const childrenB = readSnapshotChildren(b)
+
+  let i = 0
+  let j = 0
+
+  while (i < childrenA.length || j < childrenB.length) {
+    const childA = i < childrenA.length ? childrenA[i] : null
+    const childB = j < childrenB.length ? childrenB[j] : null
+
+    if (childB === null || (childA !== null && childA.name < childB.name)) {
+      changes.push({ type: 'remove', path: path.join(name, childA.name) })
+      i++
+    } else if (childA === null || childB.name < childA.name) {
+      changes.push({ type: 'add', path: path.join(name, childB.name) })
+      j++
+    } else {
+      diffSnapshotEntry(childA, childB, path.join(name, childA.name), changes)
+      i++
+      j++
     }
-  } finally {
-    if (fd !== -1) closeSync(fd)
   }
 }
 
-function appendFile(filepath, data, opts, cb) {
-  if (typeof opts === 'function') {
-    cb = opts
-    opts = {}
+function toSnapshotReader(snapshot) {
+  return {
+    snapshot,
+    view: new DataView(snapshot.buffer, snapshot.byteOffset, snapshot.byteLength),
+    digestLength: snapshot[6],
+    contents: (snapshot[7] & SNAPSHOT_CONTENTS) !== 0
   }
+}
 
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+function readSnapshotRecord(reader, offset) {
+  const { snapshot, view, digestLength, contents } = reader
 
-  if (!opts.flag) opts = { ...opts, flag: 'a' }
+  const kind = view.getUint8(offset)
+  const nameLength = view.getUint16(offset + 1, true)
+  const directory = kind === snapshotKinds.DIRECTORY
 
-  return writeFile(filepath, data, opts, cb)
-}
+  const start = offset
 
-function appendFileSync(filepath, data, opts) {
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+  offset += 3 + nameLength
 
-  if (!opts.flag) opts = { ...opts, flag: 'a' }
+  const name = snapshot.toString('utf8', start + 3, offset)
+  const mode = view.getUint32(offset, true)
+  const ino = view.getFloat64(offset + 20, true)
 
-  return writeFileSync(filepath, data, opts)
-}
+  offset += 28
 
-function watch(filepath, opts, cb) {
-  if (typeof opts === 'function') {
-    cb = opts
-    opts = {}
+  let digest = null
+
+  if (directory || (contents && kind === snapshotKinds.FILE)) {
+    digest = snapshot.subarray(offset, offset + digestLength)
+
+    offset += digestLength
   }
 
-  if (typeof opts === 'string') opts = { encoding: opts }
-  else if (!opts) opts = {}
+  let subtree = 0
 
-  filepath = toNamespacedPath(filepath)
+  if (directory) {
+    subtree = view.getUint32(offset, true)
 
-  return new Watcher(filepath, opts, cb)
-}
+    offset += 4
+  }
 
-class Stats {
-  constructor(
-    dev,
+  return {
+    reader,
+    kind,
+    name,
     mode,
-    nlink,
-    uid,
-    gid,
-    rdev,
-    blksize,
     ino,
-    size,
-    blocks,
-    atimeMs,
-    mtimeMs,
-    ctimeMs,
-    birthtimeMs
-  ) {
-    this.dev = dev
-    this.mode = mode
-    this.nlink = nlink
-    this.uid = uid
-    this.gid = gid
-    this.rdev = rdev
-    this.blksize = blksize
-    this.ino = ino
-    this.size = size
-    this.blocks = blocks
-    this.atimeMs = atimeMs
-    this.mtimeMs = mtimeMs
-    this.ctimeMs = ctimeMs
-    this.birthtimeMs = birthtimeMs
-    this.atime = new Date(atimeMs)
-    this.mtime = new Date(mtimeMs)
-    this.ctime = new Date(ctimeMs)
-    this.birthtime = new Date(birthtimeMs)
-  }
-
-  isDirectory() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFDIR
+    digest,
+    record: snapshot.subarray(start, offset),
+    end: offset,
+    subtree
   }
+}
 
-  isFile() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFREG
-  }
+function readSnapshotChildren(parent) {
+  const children = []
 
-  isBlockDevice() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFBLK
-  }
+  let offset = parent.end
 
-  isCharacterDevice() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFCHR
-  }
+  while (offset < parent.end + parent.subtree) {
+    const child = readSnapshotRecord(parent.reader, offset)
 
-  isFIFO() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFIFO
-  }
+    children.push(child)
 
-  isSymbolicLink() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFLNK
+    offset = child.end + child.subtree
   }
 
-  isSocket() {
-    return (this.mode & constants.S_IFMT) === constants.S_IFSOCK
-  }
+  return children
 }
 
-class StatFs {
-  constructor(type, bsize, blocks, bfree, bavail, files, ffree, frsize) {
-    this.type = type
-    this.bsize = bsize
-    this.blocks = blocks
-    this.bfree = bfree
-    this.bavail = bavail
-    this.files = files
-    this.ffree = ffree
-    this.frsize = frsize
+function normalizeSymlinkTarget(target, type, filepath) {
+  if (isWindows) {
+    if (type === constants.UV_FS_SYMLINK_JUNCTION) target = path.resolve(filepath, '..', target)
+
+    if (path.isAbsolute(target)) return path.toNamespacedPath(target)
+
+    return target.replace(/\//g, path.sep)
   }
+
+  return target
 }
 
-class Dir {
-  constructor(path, handle, opts = {}) {
-    const { encoding = 'utf8', bufferSize = 32 } = opts
+async function symlink(target, filepath, type, cb) {
+  if (typeof type === 'function') {
+    cb = type
+    type = null
+  }
 
-    this.path = path
+  filepath = toNamespacedPath(filepath)
 
+  if (typeof type === 'string') {
+    switch (type) {
+      case 'dir':
+        type = constants.UV_FS_SYMLINK_DIR
+        break
+      case 'junction':
+        type = constants.UV_FS_SYMLINK_JUNCTION
+        break
+      case 'file':
+      default:
+        type = 0
+        break
+    }
+  } else if (typeof type !== 'number') {
+    if (isWindows) {
+      target = path.resolve(filepath, '..', target)
+
+      try {
+        type = (await stat(target)).isDirectory()
+          ? constants.UV_FS_SYMLINK_DIR
+          : constants.UV_FS_SYMLINK_JUNCTION
+      } catch {
+        type = 0
+      }
+    } else {
+      type = 0
+    }
+  }
+
+  target = normalizeSymlinkTarget(target, type, filepath)
+
+  const req = FileRequest.borrow()
+
+  let err = null
+  try {
+    binding.symlink(req.handle, target, filepath, type)
+
+    await req
+  } catch (e) {
+    err = new FileError(e.message, {
+      operation: 'symlink',
+      code: e.code,
+      path: target,
+      destination: filepath
+    })
+  } finally {
+    req.return()
+  }
+
+  return done(err, cb)
+}
+
+function symlinkSync(target, filepath, type) {
+  filepath = toNamespacedPath(filepath)
+
+  if (typeof type === 'string') {
+    switch (type) {
+      case 'dir':
+        type = constants.UV_FS_SYMLINK_DIR
+        break
+      case 'junction':
+        type = constants.UV_FS_SYMLINK_JUNCTION
+        break
+      case 'file':
+      default:
+        type = 0
+        break
+    }
+  } else if (typeof type !== 'number') {
+    if (isWindows) {
+      target = path.resolve(filepath, '..', target)
+
+      try {
+        type = statSync(target).isDirectory()
+          ? constants.UV_FS_SYMLINK_DIR
+          : constants.UV_FS_SYMLINK_JUNCTION
+      } catch {
+        type = 0
+      }
+    } else {
+      type = 0
+    }
+  }
+
+  target = normalizeSymlinkTarget(target, type, filepath)
+
+  const req = FileRequest.borrow()
+
+  try {
+    binding.symlinkSync(req.handle, target, filepath, type)
+  } catch (e) {
+    throw new FileError(e.message, {
+      operation: 'symlink',
+      code: e.code,
+      path: target,
+      destination: filepath
+    })
+  } finally {
+    req.return()
+  }
+}
+
+async function opendir(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow()
+
+  let dir
+  let err = null
+  try {
+    req.retain(binding.opendir(req.handle, filepath))
+
+    await req
+
+    dir = new Dir(filepath, binding.requestResultDir(req.handle), opts)
+  } catch (e) {
+    err = new FileError(e.message, {
+      operation: 'opendir',
+      code: e.code,
+      path: filepath
+    })
+  } finally {
+    req.return()
+  }
+
+  return done(err, dir, cb)
+}
+
+function opendirSync(filepath, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  filepath = toNamespacedPath(filepath)
+
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain(binding.opendirSync(req.handle, filepath))
+
+    return new Dir(filepath, binding.requestResultDir(req.handle), opts)
+  } catch (e) {
+    throw new FileError(e.message, {
+      operation: 'opendir',
+      code: e.code,
+      path: filepath
+    })
+  } finally {
+    req.return()
+  }
+}
+
+async function readdir(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  const { withFileTypes = false, recursive = false, withStats = false } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  const queue = [filepath]
+  let result = []
+  let err = null
+  try {
+    while (queue.length !== 0) {
+      const dir = await opendir(queue.pop(), { withStats })
+
+      for await (const entry of dir) {
+        const entryPath = path.join(entry.parentPath, entry.name)
+
+        if (withFileTypes) {
+          result.push(entry)
+        } else {
+          result.push(path.relative(filepath, entryPath))
+        }
+
+        if (recursive && entry.isDirectory()) queue.push(entryPath)
+      }
+    }
+  } catch (e) {
+    result = []
+    err = e
+  }
+
+  return done(err, result, cb)
+}
+
+function readdirSync(filepath, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  const { withFileTypes = false, recursive = false } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  const queue = [filepath]
+  const result = []
+
+  while (queue.length !== 0) {
+    const dir = opendirSync(queue.pop(), opts)
+
+    for (const entry of dir) {
+      const entryPath = path.join(entry.parentPath, entry.name)
+
+      if (withFileTypes) {
+        result.push(entry)
+      } else {
+        result.push(path.relative(filepath, entryPath))
+      }
+
+      if (recursive && entry.isDirectory()) queue.push(entryPath)
+    }
+  }
+
+  return result
+}
+
+async function* glob(patterns, opts = {}) {
+  const { cwd = '.', ignore = [], dot = false, onlyFiles = true } = opts
+
+  const matcher = new GlobMatcher(patterns, dot)
+  const ignorer = new GlobMatcher(ignore, dot)
+
+  const stack = [{ path: '', states: matcher.states, ignored: ignorer.states }]
+
+  while (stack.length !== 0) {
+    const parent = stack.pop()
+
+    let dir
+    try {
+      dir = await opendir(path.join(cwd, parent.path), 'buffer')
+    } catch (err) {
+      if (parent.path !== '' && isVanishedEntry(err)) continue
+
+      throw err
+    }
+
+    try {
+      let entry
+
+      while ((entry = await dir.read()) !== null) {
+        let directory = entry.isDirectory()
+
+        if (entry.type === constants.UV_DIRENT_UNKNOWN) {
+          directory = (await lstat(path.join(dir.path, entry.name.toString()))).isDirectory()
+        }
+
+        const next = globEntry(matcher, ignorer, parent, entry.name, directory, onlyFiles)
+
+        if (next === null) continue
+
+        if (next.match) yield next.path
+
+        if (next.states.length !== 0) stack.push(next)
+      }
+    } finally {
+      await dir.close()
+    }
+  }
+}
+
+function* globSync(patterns, opts = {}) {
+  const { cwd = '.', ignore = [], dot = false, onlyFiles = true } = opts
+
+  const matcher = new GlobMatcher(patterns, dot)
+  const ignorer = new GlobMatcher(ignore, dot)
+
+  const stack = [{ path: '', states: matcher.states, ignored: ignorer.states }]
+
+  while (stack.length !== 0) {
+    const parent = stack.pop()
+
+    let dir
+    try {
+      dir = opendirSync(path.join(cwd, parent.path), 'buffer')
+    } catch (err) {
+      if (parent.path !== '' && isVanishedEntry(err)) continue
+
+      throw err
+    }
+
+    try {
+      let entry
+
+      while ((entry = dir.readSync()) !== null) {
+        let directory = entry.isDirectory()
+
+        if (entry.type === constants.UV_DIRENT_UNKNOWN) {
+          directory = lstatSync(path.join(dir.path, entry.name.toString())).isDirectory()
+        }
+
+        const next = globEntry(matcher, ignorer, parent, entry.name, directory, onlyFiles)
+
+        if (next === null) continue
+
+        if (next.match) yield next.path
+
+        if (next.states.length !== 0) stack.push(next)
+      }
+    } finally {
+      dir.closeSync()
+    }
+  }
+}
+
+// Match a directory entry against the patterns, returning `null` if neither
+// it nor anything below it can match.
+function globEntry(matcher, ignorer, parent, name, directory, onlyFiles) {
+  let ignored = parent.ignored
+
+  if (ignored.length !== 0) {
+    ignored = ignorer.step(ignored, name, directory)
+
+    // Ignored directories are pruned along with everything below them.
+    if (ignorer.flags !== 0) return null
+  }
+
+  const states = matcher.step(parent.states, name, directory)
+
+  const match = (matcher.flags & binding.GLOB_MATCH) !== 0 && !(onlyFiles && directory)
+
+  if (!match && states.length === 0) return null
+
+  return { path: path.join(parent.path, name.toString()), match, states, ignored }
+}
+
+// Directories found during traversal may be removed or become unreadable
+// before they are opened.
+function isVanishedEntry(err) {
+  return err.code === 'ENOENT' || err.code === 'ENOTDIR' || err.code === 'EACCES'
+}
+
+async function du(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const {
+    apparent = false,
+    countHardlinksOnce = true,
+    maxDepth = Infinity,
+    children = false,
+    concurrency = 4
+  } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  // Shared by all walks so that hard links are only counted once overall.
+  const links = countHardlinksOnce ? binding.diskUsageLinks() : null
+
+  let result = null
+  let err = null
+  try {
+    result = await diskUsage(filepath, apparent, 0, true, links)
+
+    if (maxDepth > 0 && (await lstat(filepath)).isDirectory()) {
+      const entries = await readdir(filepath, { withFileTypes: true })
+      const depth = maxDepth === Infinity ? -1 : maxDepth - 1
+
+      if (children) {
+        result.children = entries.map((entry) => ({
+          name: entry.name,
+          bytes: 0,
+          blocks: 0,
+          inodes: 0
+        }))
+      }
+
+      // A unit of work is walked natively as a whole and attributed to the
+      // child of the root at `index`.
+      const queue = entries.map((entry, index) => ({
+        filepath: path.join(filepath, entry.name),
+        depth,
+        self: true,
+        directory: entry.isDirectory(),
+        index
+      }))
+
+      const units = []
+      const target = Math.max(concurrency, 1) * 4
+
+      // Directories are split into their own entries and their subdirectories,
+      // breadth first, until there are enough units to keep several walks in
+      // flight, so that trees with few top-level directories are still walked
+      // in parallel.
+      for (let split = 0; queue.length > 0 && queue.length < target && split < target; ) {
+        const unit = queue.shift()
+
+        if (!unit.directory || (unit.depth >= 0 && unit.depth <= 1)) {
+          units.push(unit)
+          continue
+        }
+
+        let dirents
+        try {
+          dirents = await readdir(unit.filepath, { withFileTypes: true })
+        } catch (e) {
+          if (!isVanishedEntry(e)) throw e
+          dirents = null
+        }
+
+        // Entries of unknown type might be directories, so can't be split off.
+        if (
+          dirents === null ||
+          dirents.some((dirent) => dirent.type === constants.UV_DIRENT_UNKNOWN)
+        ) {
+          units.push(unit)
+          continue
+        }
+
+        split++
+
+        units.push({ ...unit, depth: 1, directory: false })
+
+        for (const dirent of dirents) {
+          if (!dirent.isDirectory()) continue
+
+          queue.push({
+            filepath: path.join(unit.filepath, dirent.name),
+            depth: unit.depth === -1 ? -1 : unit.depth - 1,
+            self: false,
+            directory: true,
+            index: unit.index
+          })
+        }
+      }
+
+      units.push(...queue)
+
+      let next = 0
+
+      async function worker() {
+        while (err === null && next < units.length) {
+          const unit = units[next++]
+
+          const usage = await diskUsage(unit.filepath, apparent, unit.depth, unit.self, links)
+
+          result.bytes += usage.bytes
+          result.blocks += usage.blocks
+          result.inodes += usage.inodes
+
+          if (children) {
+            const child = result.children[unit.index]
+
+            child.bytes += usage.bytes
+            child.blocks += usage.blocks
+            child.inodes += usage.inodes
+          }
+        }
+      }
+
+      const workers = []
+
+      for (let i = 0, n = Math.min(Math.max(concurrency, 1), units.length); i < n; i++) {
+        workers.push(
+          worker().catch((e) => {
+            if (err === null) err = e
+          })
+        )
+      }
+
+      await Promise.all(workers)
+    }
+  } catch (e) {
+    err = e
+  }
+
+  if (err) result = null
+
+  return done(err, result, cb)
+}
+
+function duSync(filepath, opts = {}) {
+  const {
+    apparent = false,
+    countHardlinksOnce = true,
+    maxDepth = Infinity,
+    children = false
+  } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  const links = countHardlinksOnce ? binding.diskUsageLinks() : null
+
+  const result = diskUsageSync(filepath, apparent, 0, true, links)
+
+  if (maxDepth > 0 && lstatSync(filepath).isDirectory()) {
+    const names = readdirSync(filepath)
+    const depth = maxDepth === Infinity ? -1 : maxDepth - 1
+
+    if (children) result.children = []
+
+    for (const name of names) {
+      const usage = diskUsageSync(path.join(filepath, name), apparent, depth, true, links)
+
+      result.bytes += usage.bytes
+      result.blocks += usage.blocks
+      result.inodes += usage.inodes
+
+      if (children) result.children.push({ name, ...usage })
+    }
+  }
+
+  return result
+}
+
+async function diskUsage(filepath, apparent, maxDepth, self, links) {
+  const req = FileRequest.borrow()
+  const usage = new Float64Array(3)
+
+  try {
+    req.retain([
+      binding.diskUsage(req.handle, filepath, apparent, maxDepth, self, links, usage),
+      links,
+      usage
+    ])
+
+    await req
+
+    return { bytes: usage[0], blocks: usage[1], inodes: usage[2] }
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'du', code: e.code, path: filepath })
+  } finally {
+    req.return()
+  }
+}
+
+function diskUsageSync(filepath, apparent, maxDepth, self, links) {
+  const req = FileRequest.borrow()
+  const usage = new Float64Array(3)
+
+  try {
+    binding.diskUsageSync(req.handle, filepath, apparent, maxDepth, self, links, usage)
+
+    return { bytes: usage[0], blocks: usage[1], inodes: usage[2] }
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'du', code: e.code, path: filepath })
+  } finally {
+    req.return()
+  }
+}
+
+function allocAligned(size, alignment = DIRECT_ALIGNMENT) {
+  return Buffer.from(binding.allocAligned(size, alignment))
+}
+
+// Open a file for direct I/O, bypassing the page cache. Filesystems that don't
+// support direct I/O reject the flag with `EINVAL`, in which case the file is
+// opened normally. Resolves with the file descriptor and whether direct I/O is
+// in effect.
+async function openDirect(filepath, flags, mode) {
+  if (typeof flags === 'string') flags = toFlags(flags)
+
+  if (constants.O_DIRECT === 0) return [await open(filepath, flags, mode), false]
+
+  try {
+    return [await open(filepath, flags | constants.O_DIRECT, mode), true]
+  } catch (err) {
+    if (err.code !== 'EINVAL') throw err
+  }
+
+  return [await open(filepath, flags, mode), false]
+}
+
+function openDirectSync(filepath, flags, mode) {
+  if (typeof flags === 'string') flags = toFlags(flags)
+
+  if (constants.O_DIRECT === 0) return [openSync(filepath, flags, mode), false]
+
+  try {
+    return [openSync(filepath, flags | constants.O_DIRECT, mode), true]
+  } catch (err) {
+    if (err.code !== 'EINVAL') throw err
+  }
+
+  return [openSync(filepath, flags, mode), false]
+}
+
+// Read `size` bytes from the start of a file opened for direct I/O. Every read
+// starts at an aligned position in the file and in memory and covers whole
+// blocks, including the tail of the file, which is then sliced off.
+async function readDirect(fd, size) {
+  const buffer = allocAligned(alignDirect(size) || DIRECT_ALIGNMENT)
+
+  let len = 0
+
+  while (len < size) {
+    const r = await read(fd, buffer, len, Math.min(buffer.byteLength - len, DIRECT_CHUNK), len)
+    len += r
+    if (r === 0 || r % DIRECT_ALIGNMENT !== 0) break
+  }
+
+  return buffer.subarray(0, Math.min(len, size))
+}
+
+function readDirectSync(fd, size) {
+  const buffer = allocAligned(alignDirect(size) || DIRECT_ALIGNMENT)
+
+  let len = 0
+
+  while (len < size) {
+    const r = readSync(fd, buffer, len, Math.min(buffer.byteLength - len, DIRECT_CHUNK), len)
+    len += r
+    if (r === 0 || r % DIRECT_ALIGNMENT !== 0) break
+  }
+
+  return buffer.subarray(0, Math.min(len, size))
+}
+
+// Reads the rest of a file into native memory and decodes it as UTF-8 from
+// there, without an intermediate buffer.
+async function readUtf8(fd, size) {
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain(binding.readUtf8(req.handle, fd, size))
+
+    await req
+
+    return binding.requestResultUtf8(req.handle)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'read', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+function readUtf8Sync(fd, size) {
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain(binding.readUtf8Sync(req.handle, fd, size))
+
+    return binding.requestResultUtf8(req.handle)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'read', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+async function readFile(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  const { encoding = 'buffer', parallel = 1, pool = null } = opts
+
+  let fd = -1
+  let direct = false
+  let buffer = null
+  let err = null
+  try {
+    if (opts.direct === true) [fd, direct] = await openDirect(filepath, opts.flag || 'r')
+    else fd = await open(filepath, opts.flag || 'r')
+
+    const st = await fstat(fd)
+
+    let len = 0
+
+    if (direct && st.size !== 0) {
+      buffer = await readDirect(fd, st.size)
+    } else if (isUtf8(encoding) && parallel <= 1) {
+      buffer = await readUtf8(fd, st.size)
+    } else if (st.size === 0) {
+      const buffers = []
+
+      try {
+        while (true) {
+          buffer = pool !== null ? pool.alloc(8192) : Buffer.allocUnsafe(8192)
+          buffers.push(buffer)
+          const r = await read(fd, buffer)
+          len += r
+          buffers[buffers.length - 1] = buffer.subarray(0, r)
+          if (r === 0) break
+        }
+
+        buffer = Buffer.concat(buffers)
+      } finally {
+        if (pool !== null) for (const chunk of buffers) pool.release(chunk)
+      }
+    } else if (parallel > 1) {
+      buffer = Buffer.allocUnsafe(st.size)
+
+      len = await readParallel(fd, buffer, { concurrency: parallel })
+
+      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
+    } else {
+      buffer = Buffer.allocUnsafe(st.size)
+
+      while (true) {
+        const r = await read(fd, len ? buffer.subarray(len) : buffer)
+        len += r
+        if (r === 0 || len === buffer.byteLength) break
+      }
+
+      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
+    }
+
+    if (typeof buffer !== 'string' && encoding !== 'buffer') buffer = buffer.toString(encoding)
+  } catch (e) {
+    err = e
+  } finally {
+    if (fd !== -1) await close(fd)
+  }
+
+  return done(err, buffer, cb)
+}
+
+function readFileSync(filepath, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  const { encoding = 'buffer', pool = null } = opts
+
+  let fd = -1
+  let direct = false
+  try {
+    if (opts.direct === true) [fd, direct] = openDirectSync(filepath, opts.flag || 'r')
+    else fd = openSync(filepath, opts.flag || 'r')
+
+    const st = fstatSync(fd)
+
+    let buffer
+    let len = 0
+
+    if (direct && st.size !== 0) {
+      buffer = readDirectSync(fd, st.size)
+    } else if (isUtf8(encoding)) {
+      buffer = readUtf8Sync(fd, st.size)
+    } else if (st.size === 0) {
+      const buffers = []
+
+      try {
+        while (true) {
+          buffer = pool !== null ? pool.alloc(8192) : Buffer.allocUnsafe(8192)
+          buffers.push(buffer)
+          const r = readSync(fd, buffer)
+          len += r
+          buffers[buffers.length - 1] = buffer.subarray(0, r)
+          if (r === 0) break
+        }
+
+        buffer = Buffer.concat(buffers)
+      } finally {
+        if (pool !== null) for (const chunk of buffers) pool.release(chunk)
+      }
+    } else {
+      buffer = Buffer.allocUnsafe(st.size)
+
+      while (true) {
+        const r = readSync(fd, len ? buffer.subarray(len) : buffer)
+        len += r
+        if (r === 0 || len === buffer.byteLength) break
+      }
+
+      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
+    }
+
+    if (typeof buffer !== 'string' && encoding !== 'buffer') buffer = buffer.toString(encoding)
+
+    return buffer
+  } finally {
+    if (fd !== -1) closeSync(fd)
+  }
+}
+
+// `cursor`, if given, has its `position` set past the lines of each positional
+// batch as it's returned, which file handles use to track their position.
+async function* readLines(filepath, opts = {}, cursor = null) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+
+  const { maxLineLength = 1024 * 1024, batch = 1024, position: start = -1 } = opts
+
+  const owned = typeof filepath !== 'number'
+  const fd = owned ? await open(filepath) : filepath
+
+  // Newline offsets, preceded by the number of bytes in the buffer.
+  const lines = new Uint32Array(batch + 1)
+  const buffer = Buffer.allocUnsafe(Math.max(maxLineLength + 1, 64 * 1024))
+
+  // Files opened here are read positionally, a given descriptor from its
+  // current position unless `position` is given.
+  let position = start >= 0 ? start : owned ? 0 : -1
+  let len = 0
+
+  try {
+    while (true) {
+      const count = await readLineBatch(fd, buffer, len, position, lines)
+
+      const eof = count < batch && lines[0] === len && len < buffer.byteLength
+
+      if (position !== -1) position += lines[0] - len
+
+      len = lines[0]
+
+      const result = toLines(buffer, lines, count, len, eof, opts, fd)
+
+      if (!eof) len = shiftLines(buffer, lines, count, len)
+
+      // The tail left in the buffer hasn't been returned yet.
+      if (cursor !== null && position !== -1) cursor.position = position - (eof ? 0 : len)
+
+      if (result.length > 0) yield result
+
+      if (eof) break
+    }
+  } finally {
+    if (owned) await close(fd)
+  }
+}
+
+function* readLinesSync(filepath, opts = {}) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+
+  const { maxLineLength = 1024 * 1024, batch = 1024, position: start = -1 } = opts
+
+  const owned = typeof filepath !== 'number'
+  const fd = owned ? openSync(filepath) : filepath
+
+  const lines = new Uint32Array(batch + 1)
+  const buffer = Buffer.allocUnsafe(Math.max(maxLineLength + 1, 64 * 1024))
+
+  let position = start >= 0 ? start : owned ? 0 : -1
+  let len = 0
+
+  try {
+    while (true) {
+      const count = readLineBatchSync(fd, buffer, len, position, lines)
+
+      const eof = count < batch && lines[0] === len && len < buffer.byteLength
+
+      if (position !== -1) position += lines[0] - len
+
+      len = lines[0]
+
+      const result = toLines(buffer, lines, count, len, eof, opts, fd)
+
+      if (result.length > 0) yield result
+
+      if (eof) break
+
+      len = shiftLines(buffer, lines, count, len)
+    }
+  } finally {
+    if (owned) closeSync(fd)
+  }
+}
+
+async function readLineBatch(fd, buffer, len, position, lines) {
+  const req = FileRequest.borrow()
+
+  try {
+    req.retain([binding.readLines(req.handle, fd, buffer, len, position, lines), buffer, lines])
+
+    return await req
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'readLines', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+function readLineBatchSync(fd, buffer, len, position, lines) {
+  const req = FileRequest.borrow()
+
+  try {
+    return binding.readLinesSync(req.handle, fd, buffer, len, position, lines)
+  } catch (e) {
+    throw new FileError(e.message, { operation: 'readLines', code: e.code, fd })
+  } finally {
+    req.return()
+  }
+}
+
+// Decode the lines found in a batch, including the final unterminated line
+// once the end of the file is reached.
+function toLines(buffer, lines, count, len, eof, opts, fd) {
+  const { encoding = 'utf8', maxLineLength = 1024 * 1024 } = opts
+
+  const end = eof ? len : count === 0 ? 0 : lines[count] + 1
+
+  if (count < lines.length - 1 && len - end > maxLineLength) {
+    throw new FileError('line too long', { operation: 'readLines', code: 'ERANGE', fd })
+  }
+
+  // Buffers are handed out as views of a single copy of the batch.
+  const source = encoding === 'buffer' ? Buffer.from(buffer.subarray(0, end)) : buffer
+
+  const result = []
+
+  let start = 0
+
+  for (let i = 1; i <= count + 1; i++) {
+    let stop = i <= count ? lines[i] : end
+
+    if (i > count && stop === start) break
+
+    const next = stop + 1
+
+    if (stop - start > maxLineLength) {
+      throw new FileError('line too long', { operation: 'readLines', code: 'ERANGE', fd })
+    }
+
+    if (stop > start && source[stop - 1] === 0x0d) stop--
+
+    result.push(
+      encoding === 'buffer' ? source.subarray(start, stop) : source.toString(encoding, start, stop)
+    )
+
+    start = next
+  }
+
+  return result
+}
+
+// Move the unconsumed tail of a batch to the front of the buffer.
+function shiftLines(buffer, lines, count, len) {
+  if (count === 0) return len
+
+  const end = lines[count] + 1
+
+  buffer.copyWithin(0, end, len)
+
+  return len - end
+}
+
+async function writeFile(filepath, data, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  if (typeof data === 'string' && (opts.writeback || !isUtf8(opts.encoding || 'utf8'))) {
+    data = Buffer.from(data, opts.encoding)
+  }
+
+  let fd = -1
+  let len = 0
+  let err = null
+  try {
+    fd = await open(filepath, opts.flag || 'w', opts.mode || 0o666)
+
+    if (typeof data === 'string') {
+      len = await writeUtf8(fd, data, -1)
+    } else {
+      if (opts.writeback) {
+        const wb = toWritebackOptions(opts.writeback)
+
+        const start = isAppend(opts.flag || 'w') ? (await fstat(fd)).size : 0
+
+        const writeback = new FileWriteback(fd, wb, start)
+
+        // Write a window at a time so that write-back keeps pace with the data.
+        while (len < data.byteLength) {
+          const end = Math.min(len + wb.window, data.byteLength)
+          len += await write(fd, data.subarray(len, end))
+          await writeback.update(start + len)
+        }
+      }
+
+      while (len < data.byteLength) {
+        len += await write(fd, len ? data.subarray(len) : data)
+      }
+    }
+  } catch (e) {
+    err = e
+  } finally {
+    if (fd !== -1) await close(fd)
+  }
+
+  return done(err, len, cb)
+}
+
+function writeFileSync(filepath, data, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  if (typeof data === 'string' && (opts.writeback || !isUtf8(opts.encoding || 'utf8'))) {
+    data = Buffer.from(data, opts.encoding)
+  }
+
+  let fd = -1
+  try {
+    fd = openSync(filepath, opts.flag || 'w', opts.mode || 0o666)
+
+    let len = 0
+
+    if (typeof data === 'string') {
+      writeUtf8Sync(fd, data, -1)
+    } else {
+      if (opts.writeback) {
+        const wb = toWritebackOptions(opts.writeback)
+
+        const start = isAppend(opts.flag || 'w') ? fstatSync(fd).size : 0
+
+        const writeback = new FileWriteback(fd, wb, start)
+
+        while (len < data.byteLength) {
+          const end = Math.min(len + wb.window, data.byteLength)
+          len += writeSync(fd, data.subarray(len, end))
+          writeback.updateSync(start + len)
+        }
+      }
+
+      while (len < data.byteLength) {
+        len += writeSync(fd, len ? data.subarray(len) : data)
+      }
+    }
+  } finally {
+    if (fd !== -1) closeSync(fd)
+  }
+}
+
+function appendFile(filepath, data, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  if (!opts.flag) opts = { ...opts, flag: 'a' }
+
+  return writeFile(filepath, data, opts, cb)
+}
+
+function appendFileSync(filepath, data, opts) {
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  if (!opts.flag) opts = { ...opts, flag: 'a' }
+
+  return writeFileSync(filepath, data, opts)
+}
+
+function watch(filepath, opts, cb) {
+  if (typeof opts === 'function') {
+    cb = opts
+    opts = {}
+  }
+
+  if (typeof opts === 'string') opts = { encoding: opts }
+  else if (!opts) opts = {}
+
+  filepath = toNamespacedPath(filepath)
+
+  return new Watcher(filepath, opts, cb)
+}
+
+// Stat watchers shared by `watchFile()` calls with the same options, and the
+// files watched by them.
+const statWatchers = new Map()
+const watchedFiles = new Map()
+
+function watchFile(filepath, opts, listener) {
+  if (typeof opts === 'function') {
+    listener = opts
+    opts = {}
+  }
+
+  if (!opts) opts = {}
+
+  const { interval = 5007, jitter = 0, persistent = true } = opts
+
+  filepath = toNamespacedPath(filepath)
+
+  let file = watchedFiles.get(filepath)
+
+  if (file === undefined) {
+    const key = interval + ':' + jitter + ':' + persistent
+
+    let watcher = statWatchers.get(key)
+
+    if (watcher === undefined) {
+      watcher = new StatWatcher([], { interval, jitter, persistent })
+
+      // Failed sweeps are retried at the next interval, so aren't reported to
+      // the listeners of individual files.
+      watcher.on('error', () => {})
+
+      watcher.on('change', (changes) => {
+        for (const { filename, curr, prev } of changes) {
+          const file = watchedFiles.get(filename)
+
+          if (file === undefined || file.watcher !== watcher) continue
+
+          for (const listener of [...file.listeners]) listener(curr, prev)
+        }
+      })
+
+      statWatchers.set(key, watcher)
+    }
+
+    file = { key, watcher, listeners: [] }
+
+    watchedFiles.set(filepath, file)
+
+    watcher.add(filepath)
+  }
+
+  if (listener) file.listeners.push(listener)
+
+  return file.watcher
+}
+
+function unwatchFile(filepath, listener) {
+  filepath = toNamespacedPath(filepath)
+
+  const file = watchedFiles.get(filepath)
+
+  if (file === undefined) return
+
+  if (listener) {
+    const i = file.listeners.indexOf(listener)
+
+    if (i !== -1) file.listeners.splice(i, 1)
+  } else {
+    file.listeners = []
+  }
+
+  if (file.listeners.length > 0) return
+
+  watchedFiles.delete(filepath)
+
+  file.watcher.delete(filepath)
+
+  if (file.watcher.size === 0) {
+    statWatchers.delete(file.key)
+
+    file.watcher.close()
+  }
+}
+
+// Number of fields per file in stats read in batches, matching the arguments
+// of the `Stats` constructor.
+const STAT_FIELDS = 14
+
+class Stats {
+  constructor(
+    dev,
+    mode,
+    nlink,
+    uid,
+    gid,
+    rdev,
+    blksize,
+    ino,
+    size,
+    blocks,
+    atimeMs,
+    mtimeMs,
+    ctimeMs,
+    birthtimeMs
+  ) {
+    this.dev = dev
+    this.mode = mode
+    this.nlink = nlink
+    this.uid = uid
+    this.gid = gid
+    this.rdev = rdev
+    this.blksize = blksize
+    this.ino = ino
+    this.size = size
+    this.blocks = blocks
+    this.atimeMs = atimeMs
+    this.mtimeMs = mtimeMs
+    this.ctimeMs = ctimeMs
+    this.birthtimeMs = birthtimeMs
+    this.atime = new Date(atimeMs)
+    this.mtime = new Date(mtimeMs)
+    this.ctime = new Date(ctimeMs)
+    this.birthtime = new Date(birthtimeMs)
+  }
+
+  isDirectory() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFDIR
+  }
+
+  isFile() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFREG
+  }
+
+  isBlockDevice() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFBLK
+  }
+
+  isCharacterDevice() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFCHR
+  }
+
+  isFIFO() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFIFO
+  }
+
+  isSymbolicLink() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFLNK
+  }
+
+  isSocket() {
+    return (this.mode & constants.S_IFMT) === constants.S_IFSOCK
+  }
+}
+
+class StatFs {
+  constructor(type, bsize, blocks, bfree, bavail, files, ffree, frsize) {
+    this.type = type
+    this.bsize = bsize
+    this.blocks = blocks
+    this.bfree = bfree
+    this.bavail = bavail
+    this.files = files
+    this.ffree = ffree
+    this.frsize = frsize
+  }
+}
+
+class Dir {
+  constructor(path, handle, opts = {}) {
+    const { encoding = 'utf8', bufferSize = 32, maxBufferSize = 4096, withStats = false } = opts
+
+    this.path = path
+
+    this._encoding = encoding
+    this._utf8 = isUtf8(encoding)
+    this._capacity = bufferSize
+    this._maxCapacity = Math.max(bufferSize, maxBufferSize)
+    this._withStats = withStats
+    this._dirents = null
+    this._stats = null
+    this._buffer = new FIFO()
+    this._ended = false
+    this._handle = handle
+  }
+
+  async read(cb) {
+    if (this._buffer.length) return ok(this._buffer.shift(), cb)
+    if (this._ended) return ok(null, cb)
+
+    const req = FileRequest.borrow()
+
+    let entries
+    let err = null
+    try {
+      this._reserve()
+
+      if (this._stats === null) {
+        binding.readdir(req.handle, this._handle, this._dirents, this._capacity)
+      } else {
+        req.retain(
+          binding.readdirStats(
+            req.handle,
+            this._handle,
+            this.path,
+            this._dirents,
+            this._capacity,
+            this._stats
+          )
+        )
+      }
+
+      await req
+
+      entries = binding.requestResultDirents(req.handle, this._utf8)
+    } catch (e) {
+      err = new FileError(e.message, {
+        operation: 'readdir',
+        code: e.code,
+        path: this.path
+      })
+    } finally {
+      req.return()
+    }
+
+    if (err) return fail(err, cb)
+
+    if (entries.length === 0) {
+      this._ended = true
+
+      return ok(null, cb)
+    }
+
+    this._push(entries)
+
+    return ok(this._buffer.shift(), cb)
+  }
+
+  readSync() {
+    if (this._buffer.length) return this._buffer.shift()
+    if (this._ended) return null
+
+    const req = FileRequest.borrow()
+
+    let entries
+    try {
+      this._reserve()
+
+      if (this._stats === null) {
+        binding.readdirSync(req.handle, this._handle, this._dirents, this._capacity)
+      } else {
+        req.retain(
+          binding.readdirStatsSync(
+            req.handle,
+            this._handle,
+            this.path,
+            this._dirents,
+            this._capacity,
+            this._stats
+          )
+        )
+      }
+
+      entries = binding.requestResultDirents(req.handle, this._utf8)
+    } catch (e) {
+      throw new FileError(e.message, {
+        operation: 'readdir',
+        code: e.code,
+        path: this.path
+      })
+    } finally {
+      req.return()
+    }
+
+    if (entries.length === 0) {
+      this._ended = true
+
+      return null
+    }
+
+    this._push(entries)
+
+    return this._buffer.shift()
+  }
+
+  async close(cb) {
+    const req = FileRequest.borrow()
+
+    let err = null
+    try {
+      binding.closedir(req.handle, this._handle)
+
+      await req
+    } catch (e) {
+      err = new FileError(e.message, {
+        operation: 'closedir',
+        code: e.code,
+        path: this.path
+      })
+    } finally {
+      req.return()
+    }
+
+    this._handle = null
+
+    return done(err, cb)
+  }
+
+  closeSync() {
+    const req = FileRequest.borrow()
+
+    try {
+      binding.closedirSync(req.handle, this._handle)
+    } catch (e) {
+      throw new FileError(e.message, {
+        operation: 'closedir',
+        code: e.code,
+        path: this.path
+      })
+    } finally {
+      req.return()
+    }
+
+    this._handle = null
+  }
+
+  [Symbol.dispose]() {
+    this.closeSync()
+  }
+
+  async [Symbol.asyncDispose]() {
+    await this.close()
+  }
+
+  // Allocates the buffers for a batch of entries, which are reused across
+  // reads until the batch size grows.
+  _reserve() {
+    const byteLength = this._capacity * binding.SIZEOF_DIRENT
+
+    if (this._dirents !== null && this._dirents.byteLength === byteLength) return
+
+    this._dirents = new ArrayBuffer(byteLength)
+
+    if (this._withStats) this._stats = new Float64Array(this._capacity * STAT_FIELDS)
+  }
+
+  _push(entries) {
+    // Full batches suggest a large directory, so grow the batch size to need
+    // fewer reads for the rest of it.
+    if (entries.length === this._capacity) {
+      this._capacity = Math.min(this._capacity * 2, this._maxCapacity)
+    }
+
+    for (let i = 0; i < entries.length; i++) {
+      const entry = entries[i]
+
+      let name = entry.name
+
+      if (!this._utf8) {
+        name = Buffer.from(name)
+
+        if (this._encoding !== 'buffer') name = name.toString(this._encoding)
+      }
+
+      let stats = null
+
+      // Entries that could not be stat'ed have all fields set to zero.
+      if (this._stats !== null && this._stats[i * STAT_FIELDS + 1] !== 0) {
+        stats = new Stats(...this._stats.subarray(i * STAT_FIELDS, (i + 1) * STAT_FIELDS))
+      }
+
+      this._buffer.push(new Dirent(this.path, name, entry.type, stats))
+    }
+  }
+
+  *[Symbol.iterator]() {
+    while (true) {
+      const entry = this.readSync()
+      if (entry === null) break
+      yield entry
+    }
+
+    this.closeSync()
+  }
+
+  async *[Symbol.asyncIterator]() {
+    while (true) {
+      const entry = await this.read()
+      if (entry === null) break
+      yield entry
+    }
+
+    await this.close()
+  }
+}
+
+class Dirent {
+  constructor(parentPath, name, type, stats = null) {
+    this.parentPath = parentPath
+    this.name = name
+    this.type = type
+    this.stats = stats
+  }
+
+  isFile() {
+    return this.type === constants.UV_DIRENT_FILE
+  }
+
+  isDirectory() {
+    return this.type === constants.UV_DIRENT_DIR
+  }
+
+  isSymbolicLink() {
+    return this.type === constants.UV_DIRENT_LINK
+  }
+
+  isFIFO() {
+    return this.type === constants.UV_DIRENT_FIFO
+  }
+
+  isSocket() {
+    return this.type === constants.UV_DIRENT_SOCKET
+  }
+
+  isCharacterDevice() {
+    return this.type === constants.UV_DIRENT_CHAR
+  }
+
+  isBlockDevice() {
+    return this.type === constants.UV_DIRENT_BLOCK
+  }
+}
+
+// Hands out buffers as subarrays of large, natively allocated slabs. A slab is
+// recycled once every buffer allocated from it has been released, and slabs
+// beyond `maxFreeSlabs` are left to the garbage collector.
+//
+// Only the current and free slabs are referenced by the pool. Slabs with
+// buffers still out are only looked up weakly, so that buffers that are never
+// released, such as those of destroyed streams, don't keep them alive.
+class BufferPool {
+  constructor(opts = {}) {
+    const { slabSize = 1024 * 1024, maxFreeSlabs = 4 } = opts
+
+    this.slabSize = slabSize
+    this.maxFreeSlabs = maxFreeSlabs
+
+    this._slab = null
+    this._free = []
+    this._slabs = new WeakMap()
+    this._size = 0
+    this._collected = new FinalizationRegistry(() => this._size--)
+  }
+
+  get size() {
+    return this._size
+  }
+
+  alloc(size) {
+    if (size > this.slabSize) return Buffer.allocUnsafe(size)
+
+    let slab = this._slab
+
+    if (slab === null || slab.offset + size > slab.buffer.byteLength) {
+      if (slab !== null && slab.refs === 0) this._recycle(slab)
+
+      slab = this._slab = this._free.length > 0 ? this._free.pop() : this._create()
+    }
+
+    const buffer = slab.buffer.subarray(slab.offset, slab.offset + size)
+
+    slab.offset += size
+    slab.refs++
+
+    return buffer
+  }
+
+  release(buffer) {
+    const slab = this._slabs.get(buffer.buffer)
+
+    if (slab === undefined || slab.refs === 0) return
+
+    if (--slab.refs > 0) return
+
+    if (slab === this._slab) slab.offset = 0
+    else this._recycle(slab)
+  }
+
+  // Shorten a buffer to `len` bytes, giving the remainder back to the slab if
+  // it was the most recent allocation.
+  _trim(buffer, len) {
+    const slab = this._slabs.get(buffer.buffer)
+
+    if (slab === this._slab && slab.offset === buffer.byteOffset + buffer.byteLength) {
+      slab.offset -= buffer.byteLength - len
+    }
+
+    return buffer.subarray(0, len)
+  }
+
+  _create() {
+    const slab = { buffer: allocAligned(this.slabSize), offset: 0, refs: 0 }
+
+    this._slabs.set(slab.buffer.buffer, slab)
+    this._size++
+
+    // Slabs abandoned with buffers still out are no longer owned once
+    // collected.
+    this._collected.register(slab.buffer.buffer, null, slab)
+
+    return slab
+  }
+
+  _recycle(slab) {
+    if (this._free.length < this.maxFreeSlabs) {
+      slab.offset = 0
+      this._free.push(slab)
+    } else {
+      this._slabs.delete(slab.buffer.buffer)
+      this._size--
+      this._collected.unregister(slab)
+    }
+  }
+}
+
+class FileReadStream extends Readable {
+  constructor(path, opts = {}) {
+    const { eagerOpen = true } = opts
+
+    super({ eagerOpen, ...opts })
+
+    this.path = path
+    this.fd = typeof opts.fd === 'number' ? opts.fd : -1
+    this.flags = opts.flags || 'r'
+    this.mode = opts.mode || 0o666
+    this.sparse = opts.sparse === true
+    this.direct = opts.direct === true
+    this.pool = opts.pool || null
+
+    this._offset = opts.start || 0
+    this._missing = 0
+
+    // The current range of data when reading sparsely, everything before it
+    // is a hole.
+    this._data = null
+
+    if (opts.length) {
+      this._missing = opts.length
+    } else if (typeof opts.end === 'number') {
+      this._missing = opts.end - this._offset + 1
+    } else {
+      this._missing = -1
+    }
+  }
+
+  async _open(cb) {
+    let err
+
+    if (this.fd === -1) {
+      err = null
+      try {
+        if (this.direct) [this.fd, this.direct] = await openDirect(this.path, this.flags, this.mode)
+        else this.fd = await open(this.path, this.flags, this.mode)
+      } catch (e) {
+        err = e
+      }
+
+      if (err) return cb(err)
+    }
+
+    let st
+    err = null
+    try {
+      st = await fstat(this.fd)
+    } catch (e) {
+      err = e
+    }
+
+    if (err) return cb(err)
+
+    if (this._missing === -1) this._missing = st.size
+
+    if (st.size < this._offset) {
+      this._offset = st.size
+      this._missing = 0
+    } else if (st.size < this._offset + this._missing) {
+      this._missing = st.size - this._offset
+    }
+
+    cb(null)
+  }
+
+  async _read(size) {
+    if (this._missing <= 0) return this.push(null)
+
+    if (this.sparse) {
+      if (this._data === null || this._data.end <= this._offset) {
+        const range = new Float64Array(2)
+
+        let err = null
+        try {
+          if ((await readDataRanges(this.fd, this._offset, range)) === 0) {
+            this._data = { start: Infinity, end: Infinity }
+          } else {
+            this._data = { start: range[0], end: range[0] + range[1] }
+          }
+        } catch (e) {
+          err = e
+        }
+
+        if (err) return this.destroy(err)
+      }
+
+      if (this._offset < this._data.start) {
+        const len = Math.min(this._missing, size, this._data.start - this._offset)
+
+        this._missing -= len
+        this._offset += len
+
+        return this.push(this._alloc(len).fill(0)) // Holes read as zeros
+      }
+
+      size = Math.min(size, this._data.end - this._offset)
+    }
+
+    if (this.direct) return this._readDirect(size)
+
+    const data = this._alloc(Math.min(this._missing, size))
+
+    let len
+    let err = null
+    try {
+      len = await read(this.fd, data, 0, data.byteLength, this._offset)
+    } catch (e) {
+      err = e
+    }
+
+    if (err || len === 0) {
+      if (this.pool !== null) this.pool.release(data)
+
+      return err ? this.destroy(err) : this.push(null)
+    }
+
+    if (this._missing < len) len = this._missing
+
+    this._missing -= len
+    this._offset += len
+
+    this.push(this.pool !== null ? this.pool._trim(data, len) : data.subarray(0, len))
+  }
+
+  _alloc(size) {
+    return this.pool !== null ? this.pool.alloc(size) : Buffer.allocUnsafe(size)
+  }
+
+  async _readDirect(size) {
+    const start = this._offset - (this._offset % DIRECT_ALIGNMENT)
+    const skip = this._offset - start
+
+    const data = allocAligned(alignDirect(skip + Math.min(this._missing, size)))
+
+    let len
+    let err = null
+    try {
+      len = await read(this.fd, data, 0, data.byteLength, start)
+    } catch (e) {
+      err = e
+    }
+
+    if (err) return this.destroy(err)
+
+    len -= skip
+
+    if (len <= 0) return this.push(null)
+
+    if (this._missing < len) len = this._missing
+
+    this._missing -= len
+    this._offset += len
+
+    this.push(data.subarray(skip, skip + len))
+  }
+
+  async _destroy(err, cb) {
+    if (this.fd === -1) return cb(err)
+
+    try {
+      await close(this.fd)
+    } catch (e) {
+      err = err || e
+    }
+
+    cb(err)
+  }
+}
+
+class FileWriteStream extends Writable {
+  constructor(path, opts = {}) {
+    const { eagerOpen = true } = opts
+
+    super({ eagerOpen, ...opts })
+
+    this.path = path
+    this.fd = typeof opts.fd === 'number' ? opts.fd : -1
+    this.flags = opts.flags || 'w'
+    this.mode = opts.mode || 0o666
+    this.preallocate = opts.preallocate || 0
+
+    // Writes at an explicit offset can't be combined with appending.
+    this.start = typeof opts.start === 'number' && !isAppend(this.flags) ? opts.start : null
+    this.concurrency = this.start === null ? 1 : Math.max(opts.concurrency || 1, 1)
+
+    // Direct writes are positional, so they're not supported when appending
+    // or when writing to a file descriptor at an unknown position. They also
+    // pad and truncate the end of the file, so they're not supported when
+    // writing a region of it.
+    this.direct =
+      opts.direct === true && this.fd === -1 && !isAppend(this.flags) && this.start === null
+
+    this.writeback = opts.writeback ? toWritebackOptions(opts.writeback) : null
+
+    this._position = this.start === null ? 0 : this.start
+    this._reserved = 0
+    this._size = 0 // The size of the file when opened, if preallocating
+    this._writeback = null
+
+    // Positional writes in flight, oldest first.
+    this._pending = []
+
+    // Staging buffer for direct writes, which must cover whole aligned blocks.
+    this._block = null
+    this._blockLength = 0
+  }
+
+  async _open(cb) {
+    let err = null
+    try {
+      const opened = this.fd === -1
+
+      if (opened) {
+        if (this.direct) [this.fd, this.direct] = await openDirect(this.path, this.flags, this.mode)
+        else this.fd = await open(this.path, this.flags, this.mode)
+      }
+
+      if (this.direct) this._block = allocAligned(DIRECT_CHUNK)
+
+      if (this.preallocate > 0 || this.writeback !== null) {
+        const { size } = await fstat(this.fd)
+
+        // Writes start at the end of the file when appending, and are assumed
+        // to when writing to a file descriptor at an unknown position.
+        if (this.start === null && (!opened || isAppend(this.flags))) this._position = size
+
+        this._size = size
+        this._reserved = size
+      }
+
+      if (this.writeback !== null && !this.direct) {
+        this._writeback = new FileWriteback(this.fd, this.writeback, this._position)
+      }
+    } catch (e) {
+      err = e
+    }
+
+    cb(err)
+  }
+
+  async _writev(batch, cb) {
+    const buffers = batch.map(({ chunk }) => chunk)
+
+    let err = null
+    try {
+      if (this.preallocate > 0) await this._preallocate(buffers)
+
+      if (this.direct) await this._writeDirect(buffers)
+      else if (this.start !== null) await this._writeAt(buffers)
+      else {
+        this._position += await writev(this.fd, buffers)
+
+        if (this._writeback !== null) await this._writeback.update(this._position)
+      }
+    } catch (e) {
+      err = e
+    }
+
+    cb(err)
+  }
+
+  // Positional writes are issued at increasing offsets with up to
+  // `concurrency` of them in flight. A batch is reported as written as soon as
+  // there's room for another write, and failures are reported in order by the
+  // batch that waits on the failed write.
+  async _writeAt(buffers) {
+    let len = 0
+
+    for (const buffer of buffers) len += buffer.byteLength
+
+    const position = this._position
+
+    this._position += len
+
+    this._pending.push({ end: this._position, promise: this._pwritev(buffers, position, len) })
+
+    if (this._pending.length >= this.concurrency) await this._complete()
+  }
+
+  // Resolves with the error of the write, if any, rather than rejecting so
+  // that writes in flight never cause unhandled rejections.
+  async _pwritev(buffers, position, len) {
+    try {
+      let written = await writev(this.fd, buffers, position)
+
+      // Finish short writes so that they don't leave gaps in the file.
+      if (written < len) {
+        const data = Buffer.concat(buffers)
+
+        while (written < len) {
+          written += await write(this.fd, data, written, len - written, position + written)
+        }
+      }
+
+      return null
+    } catch (err) {
+      return err
+    }
+  }
+
+  async _complete() {
+    const { end, promise } = this._pending.shift()
+
+    const err = await promise
+
+    if (err) throw err
+
+    if (this._writeback !== null) await this._writeback.update(end)
+  }
+
+  async _writeDirect(buffers) {
+    const block = this._block
+
+    for (const buffer of buffers) {
+      let offset = 0
+
+      while (offset < buffer.byteLength) {
+        const len = Math.min(buffer.byteLength - offset, block.byteLength - this._blockLength)
+
+        block.set(buffer.subarray(offset, offset + len), this._blockLength)
+
+        offset += len
+
+        this._blockLength += len
+
+        if (this._blockLength === block.byteLength) await this._flushDirect(block.byteLength)
+      }
+    }
+  }
+
+  async _flushDirect(len) {
+    let written = 0
+
+    while (written < len) {
+      written += await write(this.fd, this._block, written, len - written, this._position + written)
+    }
+
+    this._position += this._blockLength
+    this._blockLength = 0
+  }
+
+  async _final(cb) {
+    let err = null
+    try {
+      while (this._pending.length > 0) await this._complete()
+
+      if (this.direct && this._blockLength !== 0) {
+        // Pad the tail to a whole block and then truncate the file back to the
+        // number of bytes actually written.
+        const len = alignDirect(this._blockLength)
+
+        this._block.fill(0, this._blockLength, len)
+
+        await this._flushDirect(len)
+        await ftruncate(this.fd, this._position)
+      } else if (this._reserved > this._position && this._position >= this._size) {
+        // The writes of the stream end the file, so release the space reserved
+        // past the last of them by truncating the file to its own size.
+        await ftruncate(this.fd, this._position)
+      }
+    } catch (e) {
+      err = e
+    }
+
+    cb(err)
+  }
+
+  async _preallocate(buffers) {
+    let len = 0
+
+    for (const buffer of buffers) len += buffer.byteLength
+
+    if (this._position + len <= this._reserved) return
+
+    // Reserve space in whole steps ahead of the write cursor without changing
+    // the size of the file, so that appends land in contiguous extents.
+    const end = Math.ceil((this._position + len) / this.preallocate) * this.preallocate
+
+    try {
+      await fallocate(this.fd, this._reserved, end - this._reserved, { keepSize: true })
+
+      this._reserved = end
+    } catch {
+      this.preallocate = 0 // Not supported by the platform or filesystem
+    }
+  }
+
+  async _destroy(err, cb) {
+    if (this.fd === -1) return cb(err)
+
+    // Don't close the file from under writes still in flight.
+    for (const { promise } of this._pending) await promise
+
+    this._pending = []
+
+    try {
+      await close(this.fd)
+    } catch (e) {
+      err = err || e
+    }
+
+    cb(err)
+  }
+}
+
+class Watcher extends EventEmitter {
+  constructor(path, opts, onchange) {
+    if (typeof opts === 'function') {
+      onchange = opts
+      opts = {}
+    }
+
+    if (!opts) opts = {}
+
+    const { persistent = true, recursive = false, encoding = 'utf8' } = opts
+
+    super()
+
+    this._closed = false
     this._encoding = encoding
-    this._capacity = bufferSize
-    this._buffer = new FIFO()
-    this._ended = false
-    this._handle = handle
+    this._utf8 = isUtf8(encoding)
+    this._handle = binding.watcherInit(
+      path,
+      recursive,
+      this._utf8,
+      this,
+      this._onevent,
+      this._onclose
+    )
+
+    if (!persistent) this.unref()
+
+    if (onchange) this.on('change', onchange)
   }
 
-  async read(cb) {
-    if (this._buffer.length) return ok(this._buffer.shift(), cb)
-    if (this._ended) return ok(null, cb)
+  close() {
+    if (this._closed) return
+    this._closed = true
+
+    binding.watcherClose(this._handle)
+  }
+
+  ref() {
+    if (this._handle) binding.watcherRef(this._handle)
+    return this
+  }
+
+  unref() {
+    if (this._handle) binding.watcherUnref(this._handle)
+    return this
+  }
+
+  [Symbol.asyncIterator]() {
+    const buffer = []
+    let done = false
+    let error = null
+    let next = null
+
+    this.on('change', (eventType, filename) => {
+      if (next) {
+        next.resolve({ done: false, value: { eventType, filename } })
+        next = null
+      } else {
+        buffer.push({ eventType, filename })
+      }
+    })
+      .on('error', (err) => {
+        done = true
+        error = err
+
+        if (next) {
+          next.reject(error)
+          next = null
+        }
+      })
+      .on('close', () => {
+        done = true
+
+        if (next) {
+          next.resolve({ done })
+          next = null
+        }
+      })
+
+    return {
+      next: () =>
+        new Promise((resolve, reject) => {
+          if (error) return reject(error)
+
+          if (buffer.length) return resolve({ done: false, value: buffer.shift() })
+
+          if (done) return resolve({ done })
+
+          next = { resolve, reject }
+        })
+    }
+  }
+
+  _onevent(err, events, filename) {
+    if (err) {
+      this.close()
+      this.emit('error', err)
+    } else {
+      let path = filename
+
+      if (!this._utf8) {
+        path = Buffer.from(filename)
+
+        if (this._encoding !== 'buffer') path = path.toString(this._encoding)
+      }
+
+      if (events & binding.UV_RENAME) {
+        this.emit('change', 'rename', path)
+      }
+
+      if (events & binding.UV_CHANGE) {
+        this.emit('change', 'change', path)
+      }
+    }
+  }
+
+  _onclose() {
+    this._handle = null
+
+    this.emit('close')
+  }
+}
+
+class StatWatcher extends EventEmitter {
+  constructor(filenames = [], opts, onchange) {
+    if (typeof opts === 'function') {
+      onchange = opts
+      opts = {}
+    }
+
+    if (!opts) opts = {}
+
+    const { interval = 5007, jitter = 0, persistent = true } = opts
+
+    super()
+
+    this.interval = interval
+    this.jitter = jitter
+
+    this._closed = false
+    this._persistent = persistent
+    this._timer = null
+    this._watched = new Set()
+    this._changed = false
+
+    // The files of the current sweep and their stats, rebuilt before a sweep
+    // when files have been added or deleted.
+    this._files = []
+    this._index = new Map()
+    this._paths = Buffer.alloc(0)
+    this._prev = new Float64Array(0)
+    this._next = new Float64Array(0)
+    this._updated = new Uint32Array(0)
+
+    for (const filename of filenames) this.add(filename)
+
+    if (onchange) this.on('change', onchange)
+
+    this._schedule(0)
+  }
+
+  get size() {
+    return this._watched.size
+  }
+
+  has(filename) {
+    return this._watched.has(toNamespacedPath(filename))
+  }
+
+  add(filename) {
+    filename = toNamespacedPath(filename)
+
+    if (!this._watched.has(filename)) {
+      this._watched.add(filename)
+      this._changed = true
+    }
+
+    return this
+  }
+
+  delete(filename) {
+    if (!this._watched.delete(toNamespacedPath(filename))) return false
+
+    this._changed = true
+
+    return true
+  }
+
+  close() {
+    if (this._closed) return
+    this._closed = true
+
+    if (this._timer !== null) {
+      clearTimeout(this._timer)
+      this._timer = null
+    }
+
+    this.emit('close')
+  }
+
+  ref() {
+    this._persistent = true
+
+    if (this._timer !== null) this._timer.ref()
+
+    return this
+  }
+
+  unref() {
+    this._persistent = false
+
+    if (this._timer !== null) this._timer.unref()
+
+    return this
+  }
+
+  _schedule(delay) {
+    if (this._closed) return
+
+    this._timer = setTimeout(() => this._sweep(), delay)
+
+    if (!this._persistent) this._timer.unref()
+  }
+
+  _rebuild() {
+    const files = [...this._watched]
+    const prev = new Float64Array(files.length * STAT_FIELDS)
+    const index = new Map()
+
+    for (let i = 0; i < files.length; i++) {
+      const j = this._index.get(files[i])
+
+      // Files without a previous sweep have no stats to compare against yet.
+      if (j === undefined) {
+        prev.fill(NaN, i * STAT_FIELDS, (i + 1) * STAT_FIELDS)
+      } else {
+        prev.set(this._prev.subarray(j * STAT_FIELDS, (j + 1) * STAT_FIELDS), i * STAT_FIELDS)
+      }
+
+      index.set(files[i], i)
+    }
+
+    this._files = files
+    this._index = index
+    this._paths = Buffer.from(files.map((filename) => filename + '\0').join(''))
+    this._prev = prev
+    this._next = new Float64Array(prev.length)
+    this._updated = new Uint32Array(files.length)
+    this._changed = false
+  }
+
+  async _sweep() {
+    this._timer = null
+
+    let changes = null
+    let err = null
+
+    try {
+      changes = await this._poll()
+    } catch (e) {
+      err = e
+    }
+
+    if (this._closed) return
+
+    // The next sweep is scheduled even if this one failed, which leaves the
+    // previous stats in place to compare against.
+    this._schedule(this.interval + Math.floor(Math.random() * this.jitter))
+
+    if (err !== null) this.emit('error', err)
+    else if (changes.length > 0) this.emit('change', changes)
+  }
+
+  async _poll() {
+    if (this._changed) this._rebuild()
+
+    const changes = []
 
-    const req = FileRequest.borrow()
+    if (this._files.length === 0) return changes
 
-    let entries
-    let err = null
-    try {
-      req.retain(binding.readdir(req.handle, this._handle, this._capacity))
+    const req = FileRequest.borrow()
 
-      await req
+    let len
 
-      entries = binding.requestResultDirents(req.handle)
-    } catch (e) {
-      err = new FileError(e.message, {
-        operation: 'readdir',
-        code: e.code,
-        path: this.path
-      })
+    try {
+      req.retain([
+        binding.statSweep(
+          req.handle,
+          this._paths,
+          this._files.length,
+          this._prev,
+          this._next,
+          this._updated
+        ),
+        this._paths,
+        this._prev,
+        this._next,
+        this._updated
+      ])
+
+      len = await req
     } finally {
       req.return()
     }
 
-    if (err) return fail(err, cb)
+    if (this._closed) return changes
 
-    if (entries.length === 0) {
-      this._ended = true
+    for (let i = 0; i < len; i++) {
+      const j = this._updated[i]
+      const filename = this._files[j]
 
-      return ok(null, cb)
+      if (Number.isNaN(this._prev[j * STAT_FIELDS]) || !this._watched.has(filename)) continue
+
+      changes.push({
+        filename,
+        curr: new Stats(...this._next.subarray(j * STAT_FIELDS, (j + 1) * STAT_FIELDS)),
+        prev: new Stats(...this._prev.subarray(j * STAT_FIELDS, (j + 1) * STAT_FIELDS))
+      })
     }
 
-    for (const entry of entries) {
-      let name = Buffer.from(entry.name)
+    const prev = this._prev
 
-      if (this._encoding !== 'buffer') name = name.toString(this._encoding)
+    this._prev = this._next
+    this._next = prev
 
-      this._buffer.push(new Dirent(this.path, name, entry.type))
-    }
+    return changes
+  }
+}
 
-    return ok(this._buffer.shift(), cb)
+class PathCache {
+  constructor(opts = {}) {
+    const { ttl = Infinity, maxSize = 4096 } = opts
+
+    this.hits = 0
+    this.misses = 0
+
+    this._ttl = ttl
+    this._maxSize = maxSize
+    this._entries = new Map()
+    this._watchers = new Set()
   }
 
-  readSync() {
-    if (this._buffer.length) return this._buffer.shift()
-    if (this._ended) return null
+  get size() {
+    return this._entries.size
+  }
 
-    const req = FileRequest.borrow()
+  watch(root, opts = {}) {
+    const { recursive = true } = opts
 
-    let entries
-    try {
-      req.retain(binding.readdirSync(req.handle, this._handle, this._capacity))
+    root = toNamespacedPath(root)
 
-      entries = binding.requestResultDirents(req.handle)
-    } catch (e) {
-      throw new FileError(e.message, {
-        operation: 'readdir',
-        code: e.code,
-        path: this.path
+    const watcher = new Watcher(root, { persistent: false, recursive })
+
+    watcher
+      .on('change', (eventType, filename) => {
+        // File watchers report the basename of the watched file itself, which
+        // must not be mistaken for an entry below it.
+        if (filename === path.basename(root)) this.invalidate(root)
+
+        this.invalidate(filename ? path.join(root, filename) : root)
       })
-    } finally {
-      req.return()
+      .on('error', () => {
+        this._watchers.delete(watcher)
+
+        this.invalidate(root)
+      })
+      .on('close', () => {
+        this._watchers.delete(watcher)
+      })
+
+    this._watchers.add(watcher)
+
+    return watcher
+  }
+
+  invalidate(filepath) {
+    filepath = toNamespacedPath(filepath)
+
+    const prefix = filepath.endsWith(path.sep) ? filepath : filepath + path.sep
+
+    for (const [key, entry] of this._entries) {
+      if (key === filepath || key.startsWith(prefix) || this._references(entry, filepath, prefix)) {
+        this._entries.delete(key)
+      }
     }
 
-    if (entries.length === 0) {
-      this._ended = true
+    // Adding or removing an entry also changes the metadata of its parent.
+    this._entries.delete(path.dirname(filepath))
+  }
+
+  clear() {
+    this._entries.clear()
+  }
+
+  close() {
+    for (const watcher of this._watchers) watcher.close()
+
+    this._watchers.clear()
+    this._entries.clear()
+  }
+
+  [Symbol.dispose]() {
+    this.close()
+  }
+
+  _get(type, filepath) {
+    const entry = this._entries.get(filepath)
+
+    if (entry === undefined || entry[type] === undefined) {
+      this.misses++
+      return null
+    }
+
+    const result = entry[type]
 
+    if (Date.now() - result.time > this._ttl) {
+      entry[type] = undefined
+      this.misses++
       return null
     }
 
-    for (const entry of entries) {
-      let name = Buffer.from(entry.name)
+    // Refresh the recency of the entry for LRU eviction.
+    this._entries.delete(filepath)
+    this._entries.set(filepath, entry)
+
+    this.hits++
+
+    return result
+  }
+
+  _set(type, filepath, err, value) {
+    // Only cache definitive answers; transient failures are retried.
+    if (err && err.code !== 'ENOENT' && err.code !== 'ENOTDIR') return
+
+    let entry = this._entries.get(filepath)
+
+    if (entry === undefined) {
+      entry = {}
 
-      if (this._encoding !== 'buffer') name = name.toString(this._encoding)
+      if (this._entries.size >= this._maxSize) {
+        this._entries.delete(this._entries.keys().next().value)
+      }
 
-      this._buffer.push(new Dirent(this.path, name, entry.type))
+      this._entries.set(filepath, entry)
     }
 
-    return this._buffer.shift()
+    entry[type] = { error: err, value, time: Date.now() }
   }
 
-  async close(cb) {
-    const req = FileRequest.borrow()
+  _references() {
+    return false
+  }
+}
 
-    let err = null
-    try {
-      binding.closedir(req.handle, this._handle)
+class StatCache extends PathCache {}
 
-      await req
-    } catch (e) {
-      err = new FileError(e.message, {
-        operation: 'closedir',
-        code: e.code,
-        path: this.path
-      })
-    } finally {
-      req.return()
+class RealpathCache extends PathCache {
+  _references(entry, filepath, prefix) {
+    const result = entry.realpath
+
+    if (result === undefined || result.error) return false
+
+    return result.value === filepath || result.value.startsWith(prefix)
+  }
+}
+
+// Bounds the amount of dirty data a writer leaves in the page cache. Once a
+// window of data has been written, write-back of it is started and the
+// previous window is waited on, optionally dropping it from the cache.
+class FileWriteback {
+  constructor(fd, opts, position = 0) {
+    this.fd = fd
+
+    this._window = opts.window
+    this._mode = binding.WRITEBACK_WAIT | (opts.dropCache ? binding.WRITEBACK_DROP : 0)
+    this._start = position
+    this._previous = -1
+  }
+
+  async update(position) {
+    while (position - this._start >= this._window) {
+      await writeback(this.fd, this._start, this._window, 0)
+
+      if (this._previous !== -1) {
+        await writeback(this.fd, this._previous, this._window, this._mode)
+      }
+
+      this._previous = this._start
+      this._start += this._window
     }
+  }
 
-    this._handle = null
+  updateSync(position) {
+    while (position - this._start >= this._window) {
+      writebackSync(this.fd, this._start, this._window, 0)
 
-    return done(err, cb)
+      if (this._previous !== -1) {
+        writebackSync(this.fd, this._previous, this._window, this._mode)
+      }
+
+      this._previous = this._start
+      this._start += this._window
+    }
   }
+}
 
-  closeSync() {
-    const req = FileRequest.borrow()
+// Compiled form of a list of glob patterns, matched a path segment at a time
+// while traversing directories. The state of a traversal is the list of
+// pattern segments to match the entries of a directory against.
+class GlobMatcher {
+  constructor(patterns, dot) {
+    if (typeof patterns === 'string') patterns = [patterns]
 
-    try {
-      binding.closedirSync(req.handle, this._handle)
-    } catch (e) {
-      throw new FileError(e.message, {
-        operation: 'closedir',
-        code: e.code,
-        path: this.path
-      })
-    } finally {
-      req.return()
+    const sources = []
+
+    for (const pattern of patterns) {
+      for (const expanded of expandBraces(pattern)) {
+        const segments = expanded.split('/').filter((segment) => segment !== '' && segment !== '.')
+
+        if (segments.length !== 0) sources.push(segments)
+      }
     }
 
-    this._handle = null
+    this.states = new Uint32Array(sources.length)
+    this.flags = 0
+
+    let len = 0
+
+    for (let i = 0; i < sources.length; i++) {
+      this.states[i] = len
+
+      len += sources[i].length
+    }
+
+    const source = Buffer.from(sources.map((segments) => segments.join('/')).join('\0'))
+
+    this._handle = binding.compileGlob(source, dot)
+    this._next = new Uint32Array(len + 1)
   }
 
-  [Symbol.dispose]() {
-    this.closeSync()
+  step(states, name, directory) {
+    const len = binding.stepGlob(this._handle, states, name, directory, this._next)
+
+    this.flags = this._next[0]
+
+    return this._next.slice(1, len + 1)
   }
+}
 
-  async [Symbol.asyncDispose]() {
-    await this.close()
+class LogWriter {
+  constructor(fd, opts = {}) {
+    const { position = -1, maxBatchSize = 4 * 1024 * 1024, commitDelay = 0, sync = true } = opts
+
+    this.fd = fd
+    this.position = position
+
+    this._maxBatchSize = maxBatchSize
+    this._commitDelay = commitDelay
+    this._sync = sync
+    this._queue = []
+    this._queued = 0
+    this._flushing = null
+    this._timer = null
+    this._closed = false
   }
 
-  *[Symbol.iterator]() {
-    while (true) {
-      const entry = this.readSync()
-      if (entry === null) break
-      yield entry
+  append(data) {
+    if (this._closed) {
+      return Promise.reject(
+        new FileError('log writer is closed', { operation: 'append', code: 'EBADF', fd: this.fd })
+      )
     }
 
-    this.closeSync()
+    if (typeof data === 'string') data = Buffer.from(data)
+
+    return new Promise((resolve, reject) => {
+      this._queue.push({ data, resolve, reject })
+      this._queued += data.byteLength
+
+      this._schedule()
+    })
   }
 
-  async *[Symbol.asyncIterator]() {
-    while (true) {
-      const entry = await this.read()
-      if (entry === null) break
-      yield entry
+  async flush() {
+    while (this._queue.length > 0 || this._flushing !== null) {
+      await (this._flushing || this._commit())
     }
+  }
+
+  async close() {
+    this._closed = true
 
+    await this.flush()
+  }
+
+  async [Symbol.asyncDispose]() {
     await this.close()
   }
-}
 
-class Dirent {
-  constructor(parentPath, name, type) {
-    this.parentPath = parentPath
-    this.name = name
-    this.type = type
+  _schedule() {
+    if (this._flushing !== null) return
+
+    if (this._commitDelay === 0 || this._queued >= this._maxBatchSize) {
+      this._commit()
+    } else if (this._timer === null) {
+      this._timer = setTimeout(() => this._commit(), this._commitDelay)
+    }
   }
 
-  isFile() {
-    return this.type === constants.UV_DIRENT_FILE
+  _commit() {
+    if (this._timer !== null) {
+      clearTimeout(this._timer)
+      this._timer = null
+    }
+
+    if (this._flushing === null) {
+      this._flushing = this._drain().finally(() => {
+        this._flushing = null
+
+        // Appends made by the callers of the last batch as it was resolved
+        // found the commit still in flight, so schedule them now.
+        if (this._queue.length > 0) this._schedule()
+      })
+    }
+
+    return this._flushing
   }
 
-  isDirectory() {
-    return this.type === constants.UV_DIRENT_DIR
+  // Appends that arrive while a batch is being written and synced queue up
+  // behind it and are committed together as the next batch.
+  async _drain() {
+    while (this._queue.length > 0) {
+      let len = 0
+      let n = 0
+
+      while (n < this._queue.length) {
+        const { byteLength } = this._queue[n].data
+        if (n > 0 && len + byteLength > this._maxBatchSize) break
+        len += byteLength
+        n++
+      }
+
+      const batch = this._queue.splice(0, n)
+
+      this._queued -= len
+
+      let position
+      let err = null
+      try {
+        if (this.position === -1) this.position = (await fstat(this.fd)).size
+
+        position = this.position
+
+        await this._write(batch.map(({ data }) => data), position, len)
+
+        if (this._sync) await fdatasync(this.fd)
+
+        this.position += len
+      } catch (e) {
+        err = e
+      }
+
+      for (const { data, resolve, reject } of batch) {
+        if (err) reject(err)
+        else resolve(position)
+
+        position += data.byteLength
+      }
+    }
   }
 
-  isSymbolicLink() {
-    return this.type === constants.UV_DIRENT_LINK
+  async _write(buffers, position, len) {
+    let written = await writev(this.fd, buffers, position)
+
+    if (written < len) {
+      const data = Buffer.concat(buffers)
+
+      while (written < len) {
+        written += await write(this.fd, data, written, len - written, position + written)
+      }
+    }
   }
+}
 
-  isFIFO() {
-    return this.type === constants.UV_DIRENT_FIFO
+// On disk index of the directories of a tree, recording the mtime, ctime, and
+// entries of each so that a rescan only reads the directories that changed.
+// The index file starts with the magic bytes `BFTI`, a version, and the root,
+// followed by a record per directory of its path relative to the root, its
+// mtime and ctime, and its entries with their types.
+const TREE_INDEX_VERSION = 1
+
+// Directories modified this recently may change again without their mtime
+// changing, as timestamps have limited granularity, so they are read again by
+// the next scan.
+const TREE_INDEX_RACY_WINDOW = 2000
+
+class TreeIndex {
+  constructor(root, filepath) {
+    // Directories are keyed by absolute, normalized paths so that the keys
+    // built while walking match the root and the paths passed by callers.
+    this.root = toNamespacedPath(path.resolve(toNamespacedPath(root)))
+    this.path = toNamespacedPath(filepath)
+
+    this._directories = new Map()
+    this._watchers = new Set()
+    this._updating = Promise.resolve()
   }
 
-  isSocket() {
-    return this.type === constants.UV_DIRENT_SOCKET
+  get size() {
+    return this._directories.size
   }
 
-  isCharacterDevice() {
-    return this.type === constants.UV_DIRENT_CHAR
+  entries(dirpath) {
+    dirpath = toNamespacedPath(path.resolve(toNamespacedPath(dirpath)))
+
+    const directory = this._directories.get(dirpath)
+
+    if (directory === undefined) return null
+
+    return directory.entries.map(({ name, type }) => new Dirent(directory.path, name, type))
   }
 
-  isBlockDevice() {
-    return this.type === constants.UV_DIRENT_BLOCK
+  async load() {
+    let data
+    try {
+      data = await readFile(this.path)
+    } catch (err) {
+      if (err.code === 'ENOENT') return false
+
+      throw err
+    }
+
+    const directories = decodeTreeIndex(data, this.root)
+
+    if (directories === null) return false
+
+    this._directories = directories
+
+    return true
   }
-}
 
-class FileReadStream extends Readable {
-  constructor(path, opts = {}) {
-    const { eagerOpen = true } = opts
+  async save() {
+    await this._updating
 
-    super({ eagerOpen, ...opts })
+    const tmp = this.path + '.tmp'
 
-    this.path = path
-    this.fd = typeof opts.fd === 'number' ? opts.fd : -1
-    this.flags = opts.flags || 'r'
-    this.mode = opts.mode || 0o666
+    await writeFile(tmp, encodeTreeIndex(this._directories, this.root))
+    await rename(tmp, this.path)
+  }
 
-    this._offset = opts.start || 0
-    this._missing = 0
+  // Rescan the tree, returning the directories that were read again because
+  // they are new or their mtime or ctime changed.
+  async scan() {
+    const changed = []
+
+    await this._updating
+
+    await this._update(this.root, changed)
+
+    return changed
+  }
+
+  // Keep the index current as changes are reported below the root.
+  watch() {
+    const watcher = new Watcher(this.root, { persistent: false, recursive: true })
+
+    watcher
+      .on('change', (eventType, filename) => {
+        const target = filename ? path.join(this.root, filename) : this.root
+
+        if (this._directories.has(target)) this._refresh(target)
+
+        if (target !== this.root) this._refresh(path.dirname(target))
+      })
+      .on('error', () => {
+        this._watchers.delete(watcher)
+
+        // Changes may have been missed, so rescan the whole tree.
+        this._enqueue(this.root, () => this._update(this.root, []))
+      })
+      .on('close', () => {
+        this._watchers.delete(watcher)
+      })
+
+    this._watchers.add(watcher)
 
-    if (opts.length) {
-      this._missing = opts.length
-    } else if (typeof opts.end === 'number') {
-      this._missing = opts.end - this._offset + 1
-    } else {
-      this._missing = -1
-    }
+    return watcher
   }
 
-  async _open(cb) {
-    let err
+  close() {
+    for (const watcher of this._watchers) watcher.close()
+  }
 
-    if (this.fd === -1) {
-      err = null
+  // Read a single directory again after a change was reported in it, only
+  // walking the subdirectories that are new to it and dropping those that are
+  // gone, without stat'ing the rest of the tree below it.
+  _refresh(dirpath) {
+    this._enqueue(dirpath, async () => {
+      if (!this._directories.has(dirpath)) return
+
+      let st
       try {
-        this.fd = await open(this.path, this.flags, this.mode)
-      } catch (e) {
-        err = e
+        st = await lstat(dirpath)
+      } catch (err) {
+        if (err.code !== 'ENOENT' && err.code !== 'ENOTDIR') throw err
       }
 
-      if (err) return cb(err)
-    }
-
-    let st
-    err = null
-    try {
-      st = await fstat(this.fd)
-    } catch (e) {
-      err = e
-    }
+      const previous = this._directories.get(dirpath)
 
-    if (err) return cb(err)
+      if (st === undefined || !st.isDirectory() || !(await this._read(dirpath, st, []))) {
+        this._prune(dirpath, new Set())
+        return
+      }
 
-    if (this._missing === -1) this._missing = st.size
+      const directories = (directory) =>
+        directory.entries
+          .filter((entry) => entry.type === constants.UV_DIRENT_DIR)
+          .map((entry) => path.join(dirpath, entry.name))
 
-    if (st.size < this._offset) {
-      this._offset = st.size
-      this._missing = 0
-    } else if (st.size < this._offset + this._missing) {
-      this._missing = st.size - this._offset
-    }
+      const before = new Set(directories(previous))
 
-    cb(null)
-  }
+      for (const subpath of directories(this._directories.get(dirpath))) {
+        if (before.delete(subpath)) continue
 
-  async _read(size) {
-    if (this._missing <= 0) return this.push(null)
+        const seen = new Set()
 
-    const data = Buffer.allocUnsafe(Math.min(this._missing, size))
+        await this._scan(subpath, [], seen)
 
-    let len
-    let err = null
-    try {
-      len = await read(this.fd, data, 0, data.byteLength, this._offset)
-    } catch (e) {
-      err = e
-    }
+        this._prune(subpath, seen)
+      }
 
-    if (err) return this.destroy(err)
+      for (const subpath of before) this._prune(subpath, new Set())
+    })
+  }
 
-    if (len === 0) return this.push(null)
+  _enqueue(dirpath, fn) {
+    this._updating = this._updating.then(fn).catch(() => {
+      // Leave the directory to be read again by the next scan.
+      this._directories.delete(dirpath)
+    })
+  }
 
-    if (this._missing < len) len = this._missing
+  async _update(dirpath, changed) {
+    const seen = new Set()
 
-    this._missing -= len
-    this._offset += len
+    await this._scan(dirpath, changed, seen)
 
-    this.push(data.subarray(0, len))
+    this._prune(dirpath, seen)
   }
 
-  async _destroy(err, cb) {
-    if (this.fd === -1) return cb(err)
+  // Drop the directories at or below `dirpath` that weren't `seen`.
+  _prune(dirpath, seen) {
+    const prefix = dirpath.endsWith(path.sep) ? dirpath : dirpath + path.sep
+
+    for (const key of this._directories.keys()) {
+      if ((key === dirpath || key.startsWith(prefix)) && !seen.has(key)) {
+        this._directories.delete(key)
+      }
+    }
+  }
 
+  async _scan(dirpath, changed, seen) {
+    let st
     try {
-      await close(this.fd)
-    } catch (e) {
-      err = err || e
+      st = await lstat(dirpath)
+    } catch (err) {
+      if (err.code === 'ENOENT' || err.code === 'ENOTDIR') return
+
+      throw err
     }
 
-    cb(err)
-  }
-}
+    if (!st.isDirectory()) return
 
-class FileWriteStream extends Writable {
-  constructor(path, opts = {}) {
-    const { eagerOpen = true } = opts
+    seen.add(dirpath)
 
-    super({ eagerOpen, ...opts })
+    let directory = this._directories.get(dirpath)
 
-    this.path = path
-    this.fd = typeof opts.fd === 'number' ? opts.fd : -1
-    this.flags = opts.flags || 'w'
-    this.mode = opts.mode || 0o666
-  }
+    if (
+      directory === undefined ||
+      directory.mtime !== st.mtimeMs ||
+      directory.ctime !== st.ctimeMs
+    ) {
+      if (!(await this._read(dirpath, st, changed))) {
+        seen.delete(dirpath)
 
-  async _open(cb) {
-    if (this.fd !== -1) return cb(null)
+        return
+      }
 
-    let err = null
-    try {
-      this.fd = await open(this.path, this.flags, this.mode)
-    } catch (e) {
-      err = e
+      directory = this._directories.get(dirpath)
     }
 
-    cb(err)
+    for (const entry of directory.entries) {
+      if (entry.type === constants.UV_DIRENT_DIR) {
+        await this._scan(path.join(dirpath, entry.name), changed, seen)
+      }
+    }
   }
 
-  async _writev(batch, cb) {
-    let err = null
+  // Read the entries of a directory into the index, returning `false` if it
+  // no longer exists.
+  async _read(dirpath, st, changed) {
+    const entries = []
+
     try {
-      await writev(
-        this.fd,
-        batch.map(({ chunk }) => chunk)
-      )
-    } catch (e) {
-      err = e
-    }
+      for (const dirent of await readdir(dirpath, { withFileTypes: true })) {
+        let type = dirent.type
 
-    cb(err)
-  }
+        if (type === constants.UV_DIRENT_UNKNOWN) {
+          type = (await lstat(path.join(dirpath, dirent.name))).isDirectory()
+            ? constants.UV_DIRENT_DIR
+            : constants.UV_DIRENT_FILE
+        }
 
-  async _destroy(err, cb) {
-    if (this.fd === -1) return cb(err)
+        entries.push({ name: dirent.name, type })
+      }
+    } catch (err) {
+      if (err.code !== 'ENOENT') throw err
 
-    try {
-      await close(this.fd)
-    } catch (e) {
-      err = err || e
+      return false
     }
 
-    cb(err)
+    const racy = Math.max(st.mtimeMs, st.ctimeMs) > Date.now() - TREE_INDEX_RACY_WINDOW
+
+    this._directories.set(dirpath, {
+      path: dirpath,
+      mtime: racy ? -1 : st.mtimeMs,
+      ctime: st.ctimeMs,
+      entries
+    })
+
+    changed.push(dirpath)
+
+    return true
   }
 }
 
-class Watcher extends EventEmitter {
-  constructor(path, opts, onchange) {
-    if (typeof opts === 'function') {
-      onchange = opts
-      opts = {}
-    }
+function encodeTreeIndex(directories, root) {
+  const chunks = [Buffer.from('BFTI'), encodeTreeIndexHeader(root)]
 
-    if (!opts) opts = {}
+  for (const directory of directories.values()) {
+    const name = Buffer.from(path.relative(root, directory.path))
 
-    const { persistent = true, recursive = false, encoding = 'utf8' } = opts
+    const header = Buffer.alloc(24 + name.byteLength)
+    const view = new DataView(header.buffer, header.byteOffset, header.byteLength)
 
-    super()
+    view.setUint32(0, name.byteLength, true)
+    header.set(name, 4)
+    view.setFloat64(4 + name.byteLength, directory.mtime, true)
+    view.setFloat64(12 + name.byteLength, directory.ctime, true)
+    view.setUint32(20 + name.byteLength, directory.entries.length, true)
 
-    this._closed = false
-    this._encoding = encoding
-    this._handle = binding.watcherInit(path, recursive, this, this._onevent, this._onclose)
+    chunks.push(header)
 
-    if (!persistent) this.unref()
+    for (const entry of directory.entries) {
+      const name = Buffer.from(entry.name)
 
-    if (onchange) this.on('change', onchange)
-  }
+      const record = Buffer.alloc(5 + name.byteLength)
+      const view = new DataView(record.buffer, record.byteOffset, record.byteLength)
 
-  close() {
-    if (this._closed) return
-    this._closed = true
+      view.setUint8(0, entry.type)
+      view.setUint32(1, name.byteLength, true)
+      record.set(name, 5)
 
-    binding.watcherClose(this._handle)
+      chunks.push(record)
+    }
   }
 
-  ref() {
-    if (this._handle) binding.watcherRef(this._handle)
-    return this
-  }
+  return Buffer.concat(chunks)
+}
 
-  unref() {
-    if (this._handle) binding.watcherUnref(this._handle)
-    return this
+function encodeTreeIndexHeader(root) {
+  const name = Buffer.from(root)
+
+  const header = Buffer.alloc(8 + name.byteLength)
+  const view = new DataView(header.buffer, header.byteOffset, header.byteLength)
+
+  view.setUint32(0, TREE_INDEX_VERSION, true)
+  view.setUint32(4, name.byteLength, true)
+  header.set(name, 8)
+
+  return header
+}
+
+// Returns the directories of the index, or `null` if it was written by another
+// version or for another root, or is truncated.
+function decodeTreeIndex(data, root) {
+  const view = new DataView(data.buffer, data.byteOffset, data.byteLength)
+
+  const string = (start, len) => {
+    if (start + len > data.byteLength) throw new RangeError('truncated')
+
+    return data.toString('utf8', start, start + len)
   }
 
-  [Symbol.asyncIterator]() {
-    const buffer = []
-    let done = false
-    let error = null
-    let next = null
+  try {
+    if (string(0, 4) !== 'BFTI' || view.getUint32(4, true) !== TREE_INDEX_VERSION) return null
 
-    this.on('change', (eventType, filename) => {
-      if (next) {
-        next.resolve({ done: false, value: { eventType, filename } })
-        next = null
-      } else {
-        buffer.push({ eventType, filename })
-      }
-    })
-      .on('error', (err) => {
-        done = true
-        error = err
+    let offset = 12 + view.getUint32(8, true)
 
-        if (next) {
-          next.reject(error)
-          next = null
-        }
-      })
-      .on('close', () => {
-        done = true
+    if (string(12, offset - 12) !== root) return null
 
-        if (next) {
-          next.resolve({ done })
-          next = null
-        }
-      })
+    const directories = new Map()
 
-    return {
-      next: () =>
-        new Promise((resolve, reject) => {
-          if (error) return reject(error)
+    while (offset < data.byteLength) {
+      const len = view.getUint32(offset, true)
+      const dirpath = path.join(root, string(offset + 4, len))
 
-          if (buffer.length) return resolve({ done: false, value: buffer.shift() })
+      offset += 4 + len
 
-          if (done) return resolve({ done })
+      const mtime = view.getFloat64(offset, true)
+      const ctime = view.getFloat64(offset + 8, true)
+      const count = view.getUint32(offset + 16, true)
 
-          next = { resolve, reject }
-        })
-    }
-  }
+      offset += 20
 
-  _onevent(err, events, filename) {
-    if (err) {
-      this.close()
-      this.emit('error', err)
-    } else {
-      const path =
-        this._encoding === 'buffer'
-          ? Buffer.from(filename)
-          : Buffer.from(filename).toString(this._encoding)
+      const entries = []
 
-      if (events & binding.UV_RENAME) {
-        this.emit('change', 'rename', path)
-      }
+      for (let i = 0; i < count; i++) {
+        const type = view.getUint8(offset)
+        const len = view.getUint32(offset + 1, true)
 
-      if (events & binding.UV_CHANGE) {
-        this.emit('change', 'change', path)
+        entries.push({ name: string(offset + 5, len), type })
+
+        offset += 5 + len
       }
+
+      directories.set(dirpath, { path: dirpath, mtime, ctime, entries })
     }
-  }
 
-  _onclose() {
-    this._handle = null
+    return directories
+  } catch (err) {
+    if (err instanceof RangeError) return null
 
-    this.emit('close')
+    throw err
   }
 }
 
 exports.access = access
+exports.allocAligned = allocAligned
 exports.appendFile = appendFile
 exports.chmod = chmod
 exports.chown = chown
 exports.close = close
 exports.copyFile = copyFile
 exports.cp = cp
+exports.dataRanges = dataRanges
+exports.diff = diff
+exports.du = du
 exports.exists = exists
 exports.fchmod = fchmod
 exports.fchown = fchown
+exports.fallocate = fallocate
 exports.fdatasync = fdatasync
 exports.fstat = fstat
 exports.fsync = fsync
 exports.ftruncate = ftruncate
 exports.futimes = futimes
+exports.glob = glob
+exports.hashFile = hashFile
 exports.lchown = lchown
 exports.lutimes = lutimes
 exports.link = link
@@ -2702,6 +5976,9 @@ exports.open = open
 exports.opendir = opendir
 exports.read = read
 exports.readFile = readFile
+exports.readLines = readLines
+exports.readMany = readMany
+exports.readParallel = readParallel
 exports.readdir = readdir
 exports.readlink = readlink
 exports.readv = readv
@@ -2709,15 +5986,22 @@ exports.realpath = realpath
 exports.rename = rename
 exports.rm = rm
 exports.rmdir = rmdir
+exports.snapshot = snapshot
 exports.stat = stat
 exports.statfs = statfs
 exports.symlink = symlink
 exports.truncate = truncate
+exports.tryAccess = tryAccess
+exports.tryOpen = tryOpen
+exports.tryStat = tryStat
 exports.unlink = unlink
 exports.utimes = utimes
+exports.unwatchFile = unwatchFile
 exports.watch = watch
+exports.watchFile = watchFile
 exports.write = write
 exports.writeFile = writeFile
+exports.writeMany = writeMany
 exports.writev = writev
 
 exports.accessSync = accessSync
@@ -2727,14 +6011,19 @@ exports.chownSync = chownSync
 exports.closeSync = closeSync
 exports.copyFileSync = copyFileSync
 exports.cpSync = cpSync
+exports.dataRangesSync = dataRangesSync
+exports.duSync = duSync
 exports.existsSync = existsSync
 exports.fchmodSync = fchmodSync
 exports.fchownSync = fchownSync
+exports.fallocateSync = fallocateSync
 exports.fdatasyncSync = fdatasyncSync
 exports.fstatSync = fstatSync
 exports.fsyncSync = fsyncSync
 exports.ftruncateSync = ftruncateSync
 exports.futimesSync = futimesSync
+exports.globSync = globSync
+exports.hashFileSync = hashFileSync
 exports.lchownSync = lchownSync
 exports.lutimesSync = lutimesSync
 exports.linkSync = linkSync
@@ -2744,6 +6033,8 @@ exports.mkdtempSync = mkdtempSync
 exports.openSync = openSync
 exports.opendirSync = opendirSync
 exports.readFileSync = readFileSync
+exports.readLinesSync = readLinesSync
+exports.readManySync = readManySync
 exports.readSync = readSync
 exports.readdirSync = readdirSync
 exports.readlinkSync = readlinkSync
@@ -2752,23 +6043,34 @@ exports.realpathSync = realpathSync
 exports.renameSync = renameSync
 exports.rmSync = rmSync
 exports.rmdirSync = rmdirSync
+exports.snapshotSync = snapshotSync
 exports.statSync = statSync
 exports.statfsSync = statfsSync
 exports.symlinkSync = symlinkSync
 exports.truncateSync = truncateSync
+exports.tryAccessSync = tryAccessSync
+exports.tryOpenSync = tryOpenSync
+exports.tryStatSync = tryStatSync
 exports.unlinkSync = unlinkSync
 exports.utimesSync = utimesSync
 exports.writeFileSync = writeFileSync
+exports.writeManySync = writeManySync
 exports.writeSync = writeSync
 exports.writevSync = writevSync
 
 exports.promises = require('./promises')
 
 exports.Stats = Stats
+exports.BufferPool = BufferPool
 exports.StatFs = StatFs
 exports.Dir = Dir
 exports.Dirent = Dirent
 exports.Watcher = Watcher
+exports.StatWatcher = StatWatcher
+exports.StatCache = StatCache
+exports.RealpathCache = RealpathCache
+exports.LogWriter = LogWriter
+exports.TreeIndex = TreeIndex
 
 exports.ReadStream = FileReadStream
 
@@ -2791,6 +6093,137 @@ function toNamespacedPath(filepath) {
   return path.toNamespacedPath(filepath)
 }
 
+function hasParentSegment(filepath) {
+  return /(^|[\\/])\.\.([\\/]|$)/.test(filepath)
+}
+
+function requestResultString(handle, encoding) {
+  if (isUtf8(encoding)) return binding.requestResultStringUtf8(handle)
+
+  const res = Buffer.from(binding.requestResultString(handle))
+
+  return encoding === 'buffer' ? res : res.toString(encoding)
+}
+
+function encodePath(filepath, encoding) {
+  if (isUtf8(encoding)) return filepath
+
+  const res = Buffer.from(filepath)
+
+  return encoding === 'buffer' ? res : res.toString(encoding)
+}
+
+function isUtf8(encoding) {
+  return encoding === 'utf8' || encoding === 'utf-8'
+}
+
+function toManyOperations(ops) {
+  const buffers = new Array(ops.length)
+  const positions = new Array(ops.length)
+
+  for (let i = 0; i < ops.length; i++) {
+    let { buffer, position = 0, offset = 0, length } = ops[i]
+
+    if (typeof buffer === 'string') buffer = Buffer.from(buffer)
+    if (typeof length !== 'number') length = buffer.byteLength - offset
+
+    buffers[i] = new Uint8Array(buffer.buffer, buffer.byteOffset + offset, length)
+    positions[i] = position
+  }
+
+  return [buffers, positions]
+}
+
+function toFallocateMode(opts) {
+  const {
+    keepSize = false,
+    punchHole = false,
+    zeroRange = false,
+    collapseRange = false
+  } = opts
+
+  let mode = 0
+
+  if (keepSize) mode |= binding.FALLOCATE_KEEP_SIZE
+  if (punchHole) mode |= binding.FALLOCATE_PUNCH_HOLE
+  if (zeroRange) mode |= binding.FALLOCATE_ZERO_RANGE
+  if (collapseRange) mode |= binding.FALLOCATE_COLLAPSE_RANGE
+
+  return mode
+}
+
+const DIRECT_ALIGNMENT = 4096
+const DIRECT_CHUNK = 1024 * 1024
+
+function alignDirect(len) {
+  return Math.ceil(len / DIRECT_ALIGNMENT) * DIRECT_ALIGNMENT
+}
+
+function isAppend(flags) {
+  if (typeof flags === 'string') return flags.includes('a')
+
+  return (flags & constants.O_APPEND) !== 0
+}
+
+// Expand the brace alternatives of a glob pattern, such as `*.{js,ts}`, into
+// separate patterns.
+function expandBraces(pattern) {
+  let depth = 0
+  let start = -1
+
+  for (let i = 0; i < pattern.length; i++) {
+    const c = pattern[i]
+
+    if (c === '\\') i++
+    else if (c === '{') {
+      if (depth++ === 0) start = i
+    } else if (c === '}' && depth > 0 && --depth === 0) {
+      const alternatives = splitAlternatives(pattern.slice(start + 1, i))
+
+      if (alternatives.length < 2) continue
+
+      const prefix = pattern.slice(0, start)
+      const suffix = pattern.slice(i + 1)
+
+      return alternatives.flatMap((alternative) => expandBraces(prefix + alternative + suffix))
+    }
+  }
+
+  return [pattern]
+}
+
+function splitAlternatives(body) {
+  const alternatives = []
+
+  let depth = 0
+  let start = 0
+
+  for (let i = 0; i < body.length; i++) {
+    const c = body[i]
+
+    if (c === '\\') i++
+    else if (c === '{') depth++
+    else if (c === '}') depth--
+    else if (c === ',' && depth === 0) {
+      alternatives.push(body.slice(start, i))
+
+      start = i + 1
+    }
+  }
+
+  alternatives.push(body.slice(start))
+
+  return alternatives
+}
+
+function toWritebackOptions(opts) {
+  if (opts === true) opts = {}
+
+  const { window = 8 * 1024 * 1024, dropCache = false } = opts
+
+  return { window, dropCache }
+}
+
 function toFlags(flags) {
   switch (flags) {
     case 'r':
@@ -5,6 +5,7 @@ declare const constants: {
   O_CREAT: number
   O_TRUNC: number
   O_APPEND: number
+  O_DIRECT: number
 
   F_OK: number
   R_OK: number
@@ -44,6 +45,8 @@ declare const constants: {
   COPYFILE_FICLONE_FORCE: number
   UV_FS_SYMLINK_DIR: number
   UV_FS_SYMLINK_JUNCTION: number
+
+  errno: Record<string, number>
 }
 
 export = constants
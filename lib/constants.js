@@ -7,6 +7,7 @@ module.exports = {
   O_CREAT: binding.O_CREAT,
   O_TRUNC: binding.O_TRUNC,
   O_APPEND: binding.O_APPEND,
+  O_DIRECT: binding.UV_FS_O_DIRECT || 0,
 
   F_OK: binding.F_OK || 0,
   R_OK: binding.R_OK || 0,
@@ -45,5 +46,7 @@ module.exports = {
   COPYFILE_FICLONE: binding.UV_FS_COPYFILE_FICLONE,
   COPYFILE_FICLONE_FORCE: binding.UV_FS_COPYFILE_FICLONE_FORCE,
   UV_FS_SYMLINK_DIR: binding.UV_FS_SYMLINK_DIR,
-  UV_FS_SYMLINK_JUNCTION: binding.UV_FS_SYMLINK_JUNCTION
+  UV_FS_SYMLINK_JUNCTION: binding.UV_FS_SYMLINK_JUNCTION,
+
+  errno: binding.errnos
 }
@@ -3,20 +3,27 @@ import Buffer, { BufferEncoding } from 'bare-buffer'
 import {
   constants,
   AppendFileOptions,
+  CopyFileOptions,
   CpOptions,
+  DiskUsageOptions,
+  DiskUsageResult,
   Dir,
   Dirent,
   Flag,
+  HashAlgorithm,
+  HashFileOptions,
   MkdirOptions,
   OpendirOptions,
   Path,
   ReadFileOptions,
+  ReadLinesOptions,
   ReadStream,
   ReadStreamOptions,
   ReaddirOptions,
   ReadlinkOptions,
   RealpathOptions,
   RmOptions,
+  SnapshotOptions,
   StatFs,
   Stats,
   Watcher,
@@ -28,6 +35,12 @@ import {
 
 export { constants }
 
+interface FileHandleReadOptions {
+  offset?: number
+  length?: number
+  position?: number | null
+}
+
 interface FileHandleEvents extends EventMap {
   close: []
 }
@@ -35,25 +48,78 @@ interface FileHandleEvents extends EventMap {
 interface FileHandle extends EventEmitter<FileHandleEvents>, AsyncDisposable {
   readonly fd: number
 
+  position: number
+
   close(): Promise<void>
 
-  read(
-    buffer: Buffer | ArrayBufferView,
+  read<T extends ArrayBufferView = Buffer>(
+    buffer: T,
     offset?: number,
     len?: number,
     pos?: number
-  ): Promise<number>
+  ): Promise<{ bytesRead: number; buffer: T }>
 
-  readv(buffers: ArrayBufferView[], position?: number): Promise<number>
+  read<T extends ArrayBufferView = Buffer>(
+    buffer: T,
+    opts: FileHandleReadOptions
+  ): Promise<{ bytesRead: number; buffer: T }>
 
-  write(
-    data: Buffer | ArrayBufferView,
+  read<T extends ArrayBufferView>(
+    opts: FileHandleReadOptions & { buffer: T }
+  ): Promise<{ bytesRead: number; buffer: T }>
+
+  /**
+   * Without a buffer, reads into the 64 KiB scratch buffer of the handle,
+   * which is reused by subsequent reads and must be copied to be retained.
+   */
+  read(
+    opts?: FileHandleReadOptions & { buffer?: null }
+  ): Promise<{ bytesRead: number; buffer: Buffer }>
+
+  readv<T extends ArrayBufferView[]>(
+    buffers: T,
+    pos?: number
+  ): Promise<{ bytesRead: number; buffers: T }>
+
+  write<T extends ArrayBufferView>(
+    data: T,
     offset?: number,
     len?: number,
     pos?: number
-  ): Promise<number>
+  ): Promise<{ bytesWritten: number; buffer: T }>
+
+  write(
+    data: string,
+    pos?: number,
+    encoding?: BufferEncoding
+  ): Promise<{ bytesWritten: number; buffer: string }>
+
+  writev<T extends ArrayBufferView[]>(
+    buffers: T,
+    pos?: number
+  ): Promise<{ bytesWritten: number; buffers: T }>
+
+  readFile(opts: { encoding: BufferEncoding } | BufferEncoding): Promise<string>
+
+  readFile(opts?: { encoding?: 'buffer' } | 'buffer'): Promise<Buffer>
 
-  write(data: string, pos?: number, encoding?: BufferEncoding): Promise<number>
+  writeFile(
+    data: string | Buffer | ArrayBufferView,
+    opts?: { encoding?: BufferEncoding } | BufferEncoding
+  ): Promise<void>
+
+  appendFile(
+    data: string | Buffer | ArrayBufferView,
+    opts?: { encoding?: BufferEncoding } | BufferEncoding
+  ): Promise<void>
+
+  readLines(
+    opts: Omit<ReadLinesOptions, 'position'> & { encoding: 'buffer' }
+  ): AsyncIterableIterator<Buffer[]>
+
+  readLines(
+    opts?: Omit<ReadLinesOptions, 'position'> | BufferEncoding
+  ): AsyncIterableIterator<string[]>
 
   stat(): Promise<Stats>
 
@@ -102,10 +168,22 @@ export function chmod(filepath: Path, mode: string | number): Promise<void>
 
 export function chown(filepath: Path, uid: number, gid: number): Promise<void>
 
-export function copyFile(src: Path, dst: Path, mode?: number): Promise<void>
+export function copyFile(src: Path, dst: Path, mode?: number | CopyFileOptions): Promise<void>
 
 export function cp(src: Path, dst: Path, opts?: CpOptions): Promise<void>
 
+export function du(filepath: Path, opts?: DiskUsageOptions): Promise<DiskUsageResult>
+
+export function hashFile(
+  filepath: Path | number,
+  opts: HashFileOptions & { encoding: BufferEncoding }
+): Promise<string>
+
+export function hashFile(
+  filepath: Path | number,
+  opts?: (HashFileOptions & { encoding?: 'buffer' }) | HashAlgorithm
+): Promise<Buffer>
+
 export function lchown(filepath: Path, uid: number, gid: number): Promise<void>
 
 export function lutimes(filepath: Path, atime: number | Date, mtime: number | Date): Promise<void>
@@ -268,12 +346,24 @@ export function rm(filepath: Path, opts?: RmOptions): Promise<void>
 
 export function rmdir(filepath: Path): Promise<void>
 
+export function snapshot(root: Path, opts?: SnapshotOptions): Promise<Buffer>
+
 export function stat(filepath: Path): Promise<Stats>
 
 export function statfs(filepath: Path): Promise<StatFs>
 
 export function truncate(filepath: Path, len?: number): Promise<void>
 
+export function tryAccess(filepath: Path, mode?: number): Promise<number>
+
+export function tryOpen(
+  filepath: Path,
+  flags?: Flag | number,
+  mode?: string | number
+): Promise<number>
+
+export function tryStat(filepath: Path): Promise<Stats | null>
+
 export function symlink(target: Path, filepath: Path, type?: string | number): Promise<void>
 
 export function unlink(filepath: Path): Promise<void>
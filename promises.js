@@ -1,48 +1,182 @@
 const EventEmitter = require('bare-events')
 const fs = require('.')
 
+// The size of the scratch buffer of a handle, used for reads that don't
+// provide a buffer of their own.
+const SCRATCH_SIZE = 64 * 1024
+
 class FileHandle extends EventEmitter {
-  constructor(fd) {
+  constructor(fd, opts = {}) {
     super()
 
+    const { append = false, seekable = true } = opts
+
     this.fd = fd
+    this.position = 0
+
+    this._append = append
+    this._seekable = seekable
+    this._scratch = null
   }
 
   async close() {
     await fs.close(this.fd)
 
     this.fd = -1
+    this._scratch = null
     this.emit('close')
   }
 
-  async read(buffer, ...args) {
+  async read(buffer, offset, len, pos) {
+    if (buffer === undefined || buffer === null || !ArrayBuffer.isView(buffer)) {
+      ;({ buffer = null, offset, length: len, position: pos } = buffer || {})
+    } else if (typeof offset === 'object' && offset !== null) {
+      ;({ offset, length: len, position: pos } = offset)
+    }
+
+    if (buffer === null) buffer = this._borrow()
+
+    if (typeof offset !== 'number') offset = 0
+    if (typeof len !== 'number') len = buffer.byteLength - offset
+
+    const bytesRead = await fs.read(this.fd, buffer, offset, len, this._at(pos, false))
+
+    this._advance(pos, bytesRead, false)
+
     return {
-      bytesRead: await fs.read(this.fd, buffer, ...args),
+      bytesRead,
       buffer
     }
   }
 
-  async readv(buffers, ...args) {
+  async readv(buffers, pos) {
+    const bytesRead = await fs.readv(this.fd, buffers, this._at(pos, false))
+
+    this._advance(pos, bytesRead, false)
+
     return {
-      bytesRead: await fs.readv(this.fd, buffers, ...args),
+      bytesRead,
       buffers
     }
   }
 
-  async write(buffer, ...args) {
+  async write(data, offset, len, pos) {
+    let buffer = data
+
+    if (typeof data === 'string') {
+      let encoding = len
+      pos = offset
+
+      if (typeof pos === 'string') {
+        encoding = pos
+        pos = -1
+      }
+
+      buffer = Buffer.from(data, encoding)
+      offset = 0
+      len = buffer.byteLength
+    }
+
+    if (typeof offset !== 'number') offset = 0
+    if (typeof len !== 'number') len = buffer.byteLength - offset
+
+    const bytesWritten = await fs.write(this.fd, buffer, offset, len, this._at(pos, true))
+
+    this._advance(pos, bytesWritten, true)
+
     return {
-      bytesWritten: await fs.write(this.fd, buffer, ...args),
-      buffer
+      bytesWritten,
+      buffer: data
     }
   }
 
-  async writev(buffers, ...args) {
+  async writev(buffers, pos) {
+    const bytesWritten = await fs.writev(this.fd, buffers, this._at(pos, true))
+
+    this._advance(pos, bytesWritten, true)
+
     return {
-      bytesWritten: await fs.writev(this.fd, buffers, ...args),
+      bytesWritten,
       buffers
     }
   }
 
+  async readFile(opts) {
+    if (typeof opts === 'string') opts = { encoding: opts }
+    else if (!opts) opts = {}
+
+    const { encoding = 'buffer' } = opts
+
+    const st = await fs.fstat(this.fd)
+
+    let buffer
+
+    if (st.size === 0 || !this._seekable) {
+      // Files that don't report a size, such as those of procfs, and those
+      // that can't seek, such as pipes, are read through the scratch buffer
+      // until the end.
+      const scratch = this._borrow()
+      const buffers = []
+
+      while (true) {
+        const r = await fs.read(this.fd, scratch, 0, scratch.byteLength, this._at(-1, false))
+        if (r === 0) break
+        this._advance(-1, r, false)
+        buffers.push(Buffer.from(scratch.subarray(0, r)))
+      }
+
+      buffer = Buffer.concat(buffers)
+    } else {
+      buffer = Buffer.allocUnsafe(Math.max(st.size - this.position, 0))
+
+      let len = 0
+
+      while (len < buffer.byteLength) {
+        const r = await fs.read(this.fd, buffer, len, buffer.byteLength - len, this.position)
+        if (r === 0) break
+        this.position += r
+        len += r
+      }
+
+      if (len !== buffer.byteLength) buffer = buffer.subarray(0, len)
+    }
+
+    if (encoding !== 'buffer') return buffer.toString(encoding)
+
+    return buffer
+  }
+
+  async writeFile(data, opts) {
+    if (typeof opts === 'string') opts = { encoding: opts }
+    else if (!opts) opts = {}
+
+    if (typeof data === 'string') data = Buffer.from(data, opts.encoding)
+
+    let len = 0
+
+    while (len < data.byteLength) {
+      len += (await this.write(data, len, data.byteLength - len)).bytesWritten
+    }
+  }
+
+  async appendFile(data, opts) {
+    return this.writeFile(data, opts)
+  }
+
+  async *readLines(opts) {
+    if (typeof opts === 'string') opts = { encoding: opts }
+    else if (!opts) opts = {}
+
+    const cursor = { position: this._at(-1, false) }
+    const iterator = fs.readLines(this.fd, { ...opts, position: cursor.position }, cursor)
+
+    for await (const lines of iterator) {
+      if (cursor.position !== -1) this.position = cursor.position
+
+      yield lines
+    }
+  }
+
   async stat() {
     return fs.fstat(this.fd)
   }
@@ -79,13 +213,54 @@ class FileHandle extends EventEmitter {
     return fs.createWriteStream(null, { ...opts, fd: this.fd })
   }
 
+  _borrow() {
+    if (this._scratch === null) this._scratch = Buffer.allocUnsafe(SCRATCH_SIZE)
+    return this._scratch
+  }
+
+  // Reads and writes without an explicit position use and advance the position
+  // of the handle, except for writes to handles opened for appending which
+  // always go to the end of the file, and for files that can't seek, such as
+  // pipes, which are read and written in order.
+  _at(pos, write) {
+    if (!isImplicit(pos)) return pos
+    return this._seekable && !(write && this._append) ? this.position : -1
+  }
+
+  _advance(pos, len, write) {
+    if (isImplicit(pos) && this._at(pos, write) !== -1) this.position += len
+  }
+
   async [Symbol.asyncDispose]() {
     await this.close()
   }
 }
 
+function isImplicit(pos) {
+  return typeof pos !== 'number' || pos < 0
+}
+
+function isSeekable(st) {
+  return !st.isFIFO() && !st.isCharacterDevice() && !st.isSocket()
+}
+
+function isAppend(flags) {
+  if (typeof flags === 'string') return flags.includes('a')
+  return typeof flags === 'number' && (flags & fs.constants.O_APPEND) !== 0
+}
+
 exports.open = async function open(filepath, flags, mode) {
-  return new FileHandle(await fs.open(filepath, flags, mode))
+  const fd = await fs.open(filepath, flags, mode)
+
+  let st
+  try {
+    st = await fs.fstat(fd)
+  } catch (err) {
+    await fs.close(fd)
+    throw err
+  }
+
+  return new FileHandle(fd, { append: isAppend(flags), seekable: isSeekable(st) })
 }
 
 exports.access = fs.access
@@ -95,6 +270,8 @@ exports.chown = fs.chown
 exports.constants = fs.constants
 exports.copyFile = fs.copyFile
 exports.cp = fs.cp
+exports.du = fs.du
+exports.hashFile = fs.hashFile
 exports.lchown = fs.lchown
 exports.lutimes = fs.lutimes
 exports.link = fs.link
@@ -109,9 +286,13 @@ exports.realpath = fs.realpath
 exports.rename = fs.rename
 exports.rm = fs.rm
 exports.rmdir = fs.rmdir
+exports.snapshot = fs.snapshot
 exports.stat = fs.stat
 exports.statfs = fs.statfs
 exports.truncate = fs.truncate
+exports.tryAccess = fs.tryAccess
+exports.tryOpen = fs.tryOpen
+exports.tryStat = fs.tryStat
 exports.symlink = fs.symlink
 exports.unlink = fs.unlink
 exports.utimes = fs.utimes
@@ -105,6 +105,30 @@ test('access async, file missing', async (t) => {
   }
 })
 
+test('tryStat + tryAccess + tryOpen', async (t) => {
+  const { ENOENT } = fs.constants.errno
+
+  t.is(await fs.tryStat('test/fixtures/foo.txt'), null)
+  t.is(fs.tryStatSync('test/fixtures/foo.txt'), null)
+  t.is(await fs.tryAccess('test/fixtures/foo.txt'), ENOENT)
+  t.is(fs.tryAccessSync('test/fixtures/foo.txt'), ENOENT)
+  t.is(await fs.tryOpen('test/fixtures/foo.txt'), ENOENT)
+  t.is(fs.tryOpenSync('test/fixtures/foo.txt'), ENOENT)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'hello')
+
+  t.is((await fs.tryStat(file)).size, 5)
+  t.is(fs.tryStatSync(file).size, 5)
+  t.is(await fs.tryAccess(file), 0)
+  t.is(fs.tryAccessSync(file), 0)
+
+  const fd = await fs.tryOpen(file)
+  t.ok(fd >= 0)
+  await fs.close(fd)
+
+  fs.closeSync(fs.tryOpenSync(file))
+})
+
 test('chmod', async (t) => {
   t.plan(3)
 
@@ -402,6 +426,140 @@ test('read sync', async (t) => {
   fs.closeSync(fd)
 })
 
+test('readMany', async (t) => {
+  const expected = crypto.randomBytes(1024 * 16 /* 16 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', expected)
+
+  const fd = fs.openSync(file)
+
+  const a = Buffer.alloc(100)
+  const b = Buffer.alloc(100)
+  const c = Buffer.alloc(100)
+
+  const lens = await fs.readMany(fd, [
+    { buffer: a, position: 4096 },
+    { buffer: b, position: 0 },
+    { buffer: c, position: expected.byteLength - 50 }
+  ])
+
+  t.alike(lens, [100, 100, 50])
+  t.alike(a, expected.subarray(4096, 4196))
+  t.alike(b, expected.subarray(0, 100))
+  t.alike(c.subarray(0, 50), expected.subarray(expected.byteLength - 50))
+
+  fs.closeSync(fd)
+})
+
+test('writeMany + readManySync', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', false)
+
+  const fd = fs.openSync(file, 'w+')
+
+  const lens = await fs.writeMany(fd, [
+    { buffer: 'world', position: 6 },
+    { buffer: 'hello ', position: 0 },
+    { buffer: Buffer.from('xxHELLO'), offset: 2, position: 0 }
+  ])
+
+  t.alike(lens, [5, 6, 5])
+
+  const a = Buffer.alloc(6)
+  const b = Buffer.alloc(5)
+
+  t.alike(fs.readManySync(fd, [{ buffer: a, position: 0 }, { buffer: b, position: 6 }]), [6, 5])
+  t.alike(Buffer.concat([a, b]), Buffer.from('HELLO world'))
+
+  fs.closeSync(fd)
+})
+
+test('readParallel', async (t) => {
+  const expected = crypto.randomBytes(1024 * 1024 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', expected)
+
+  const fd = fs.openSync(file)
+
+  const data = Buffer.alloc(expected.byteLength)
+  const len = await fs.readParallel(fd, data, { chunkSize: 64 * 1024, concurrency: 8 })
+  t.is(len, expected.byteLength)
+  t.alike(data, expected)
+
+  const tail = Buffer.alloc(8192)
+  t.is(await fs.readParallel(fd, tail, { position: expected.byteLength - 100 }), 100)
+  t.alike(tail.subarray(0, 100), expected.subarray(expected.byteLength - 100))
+
+  fs.closeSync(fd)
+})
+
+test('readFile + parallel', async (t) => {
+  const expected = crypto.randomBytes(1024 * 512 /* 512 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', expected)
+
+  t.alike(await fs.readFile(file, { parallel: 4 }), expected)
+})
+
+test('readLines', async (t) => {
+  const expected = []
+
+  for (let i = 0; i < 5000; i++) expected.push('line ' + i + ' '.repeat(i % 100))
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', expected.join('\r\n') + '\n')
+
+  const lines = []
+
+  for await (const batch of fs.readLines(file, { batch: 100 })) {
+    t.ok(batch.length <= 100)
+
+    lines.push(...batch)
+  }
+
+  t.alike(lines, expected)
+
+  const fd = fs.openSync(file)
+
+  const buffers = []
+
+  for await (const batch of fs.readLines(fd, { encoding: 'buffer' })) buffers.push(...batch)
+
+  t.alike(buffers.map((line) => line.toString()), expected)
+
+  fs.closeSync(fd)
+
+  const offset = expected[0].length + 2
+
+  const fd2 = fs.openSync(file)
+
+  const tail = []
+
+  for (const batch of fs.readLinesSync(fd2, { position: offset })) tail.push(...batch)
+
+  t.alike(tail, expected.slice(1), 'read from position')
+  t.is(fs.readSync(fd2, Buffer.alloc(4)), 4, 'descriptor position untouched')
+
+  fs.closeSync(fd2)
+})
+
+test('readLinesSync, final line and maximum length', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'hello\n\nworld')
+
+  t.alike([...fs.readLinesSync(file)].flat(), ['hello', '', 'world'])
+
+  fs.writeFileSync(file, 'x'.repeat(200) + '\n')
+
+  t.exception(() => [...fs.readLinesSync(file, { maxLineLength: 100 })], /line too long/)
+})
+
+test('allocAligned', async (t) => {
+  const buffer = fs.allocAligned(8192)
+
+  t.is(buffer.byteLength, 8192)
+  t.is(buffer.byteOffset, 0)
+
+  t.is(fs.allocAligned(0, 512).byteLength, 0)
+})
+
 test('write', async (t) => {
   t.plan(7)
 
@@ -695,6 +853,74 @@ test('fstat', async (t) => {
   })
 })
 
+test('file handle, position + readFile + writeFile + readLines', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt')
+
+  const handle = await fs.promises.open(file, 'r+')
+
+  await handle.writeFile('foo\r\nbar\n')
+  t.is(handle.position, 9)
+
+  await handle.write('baz')
+  t.is(handle.position, 12)
+
+  handle.position = 0
+  t.is(await handle.readFile('utf8'), 'foo\r\nbar\nbaz')
+  t.is(handle.position, 12)
+
+  handle.position = 5
+  const { bytesRead, buffer } = await handle.read()
+  t.is(buffer.toString('utf8', 0, bytesRead), 'bar\nbaz')
+
+  const { buffer: head } = await handle.read(Buffer.alloc(3), { position: 0 })
+  t.is(head.toString(), 'foo')
+  t.is(handle.position, 12)
+
+  handle.position = 0
+
+  const lines = []
+  for await (const batch of handle.readLines()) lines.push(...batch)
+
+  t.alike(lines, ['foo', 'bar', 'baz'])
+  t.is(handle.position, 12)
+
+  handle.position = 5
+
+  for await (const batch of handle.readLines({ batch: 1 })) {
+    t.is(handle.position, batch[0] === 'bar' ? 9 : 12)
+  }
+
+  await handle.close()
+})
+
+test('open + read + close, callbacks', async (t) => {
+  t.plan(7)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
+
+  const result = fs.open(file, (err, fd) => {
+    t.absent(err, 'opened')
+
+    const buffer = Buffer.alloc(4)
+
+    fs.read(fd, buffer, (err, len) => {
+      t.absent(err, 'read')
+      t.is(len, 4)
+      t.alike(buffer, Buffer.from('foo\n'))
+
+      fs.close(fd, (err) => {
+        t.absent(err, 'closed')
+      })
+    })
+  })
+
+  t.is(result, undefined)
+
+  fs.open('test/fixtures/missing.txt', (err) => {
+    t.is(err.code, 'ENOENT')
+  })
+})
+
 test('fstat sync', async (t) => {
   const file = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
 
@@ -733,6 +959,76 @@ test('lstat sync', async (t) => {
   t.ok(st)
 })
 
+test('stat + cache', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
+
+  const cache = new fs.StatCache()
+
+  const a = await fs.promises.stat(file, { cache })
+  const b = await fs.promises.stat(file, { cache })
+
+  t.is(a, b, 'served from cache')
+  t.is(cache.hits, 1)
+  t.is(cache.misses, 1)
+
+  cache.invalidate(file)
+
+  t.not(await fs.promises.stat(file, { cache }), a, 'refetched after invalidation')
+  t.is(cache.misses, 2)
+})
+
+test('stat + cache, file missing', async (t) => {
+  const cache = new fs.StatCache()
+
+  t.absent(fs.existsSync('test/fixtures/foo.txt', { cache }))
+  t.absent(await fs.promises.exists('test/fixtures/foo.txt', { cache }))
+
+  t.is(cache.hits, 1, 'missing file cached')
+  t.is(cache.misses, 1)
+})
+
+test('stat + cache, ttl and maxSize', async (t) => {
+  const a = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
+  const b = await withFile(t, 'test/fixtures/bar.txt', 'bar\n')
+
+  const cache = new fs.StatCache({ ttl: 0, maxSize: 1 })
+
+  fs.statSync(a, { cache })
+  fs.statSync(b, { cache })
+
+  t.is(cache.size, 1, 'evicted least recently used')
+
+  await new Promise((resolve) => setTimeout(resolve, 10))
+
+  fs.statSync(b, { cache })
+
+  t.is(cache.hits, 0, 'expired')
+  t.is(cache.misses, 3)
+})
+
+test('stat + cache, watch', async (t) => {
+  t.plan(2)
+
+  const dir = await withDir(t, 'test/fixtures/foo')
+  const file = await withFile(t, 'test/fixtures/foo/bar.txt', 'bar\n')
+
+  const cache = new fs.StatCache()
+
+  t.teardown(() => cache.close())
+
+  const watcher = cache.watch(dir)
+
+  const st = await fs.promises.stat(file, { cache })
+
+  t.is(await fs.promises.stat(file, { cache }), st, 'served from cache')
+
+  watcher.once('change', async () => {
+    t.not(await fs.promises.stat(file, { cache }), st, 'invalidated by watcher')
+  })
+
+  await fs.promises.writeFile(file, 'baz\n')
+})
+
 test('statfs', async (t) => {
   t.plan(2)
 
@@ -785,6 +1081,19 @@ test('ftruncateSync', async (t) => {
   fs.readFile(file, (err, data) => t.alike(data, Buffer.from('hello')))
 })
 
+test('fallocate', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt')
+  const fd = fs.openSync(file, 'w+')
+
+  t.teardown(() => fs.closeSync(fd))
+
+  await fs.fallocate(fd, 0, 4096)
+  t.is(fs.fstatSync(fd).size, 4096)
+
+  fs.fallocateSync(fd, 4096, 4096, { keepSize: true })
+  t.is(fs.fstatSync(fd).size, 4096)
+})
+
 test('truncate', async (t) => {
   t.plan(3)
 
@@ -915,6 +1224,46 @@ test('futimes sync', async (t) => {
   fs.closeSync(fd)
 })
 
+test('hashFile', async (t) => {
+  const data = crypto.randomBytes(1024 * 512 /* 512 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', data)
+
+  const expected = crypto.createHash('sha256').update(data).digest('hex')
+
+  t.is(await fs.hashFile(file, { encoding: 'hex' }), expected)
+  t.is(fs.hashFileSync(file, { encoding: 'hex' }), expected)
+})
+
+test('hashFile, algorithms', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', Buffer.from('123456789'))
+
+  t.is(await fs.hashFile(file, { algorithm: 'crc32c', encoding: 'hex' }), 'e3069283')
+  t.is(
+    fs.hashFileSync(file, { algorithm: 'blake2b512', length: 3, encoding: 'hex' }),
+    'e64cb91c7c1819bdcda4dca47a2aae98e737df75ddb0287083229dc0695064616df676a0c95ae55109fe0a27ba9dee79ea9a5c9d90cceb0cf8ae80b4f61ab4a3'
+  )
+  t.is((await fs.hashFile(file, 'blake2b512')).byteLength, 64)
+
+  await t.exception(fs.hashFile(file, 'md4'), /unsupported hash algorithm/)
+})
+
+test('hashFile, fd with offset and length', async (t) => {
+  t.plan(2)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', Buffer.from('hello world'))
+  const fd = fs.openSync(file)
+
+  const expected = crypto.createHash('sha256').update('world').digest()
+
+  fs.hashFile(fd, { offset: 6, length: 5 }, (err, digest) => {
+    t.absent(err)
+    t.alike(digest, expected)
+
+    fs.closeSync(fd)
+  })
+})
+
 test('opendir + close', async (t) => {
   t.plan(2)
 
@@ -967,6 +1316,38 @@ test('opendirSync + iterator', async (t) => {
   t.pass('iterated')
 })
 
+test('opendir + growing bufferSize', async (t) => {
+  const dir = await withDir(t, 'test/fixtures/dir')
+
+  const expected = []
+
+  for (let i = 0; i < 100; i++) {
+    const name = 'file-' + String(i).padStart(3, '0')
+
+    fs.writeFileSync(path.join(dir, name), '')
+
+    expected.push(name)
+  }
+
+  const names = []
+
+  for await (const entry of await fs.promises.opendir(dir, { bufferSize: 2, maxBufferSize: 16 })) {
+    names.push(entry.name)
+  }
+
+  t.alike(names.sort(), expected)
+
+  const withStats = fs.opendirSync(dir, { bufferSize: 1, maxBufferSize: 8, withStats: true })
+
+  let count = 0
+
+  for (const entry of withStats) {
+    if (entry.stats.isFile()) count++
+  }
+
+  t.is(count, 100)
+})
+
 test('readdir', async (t) => {
   t.plan(2)
 
@@ -1057,6 +1438,108 @@ test('readdirSync + recursive: true', async (t) => {
   t.pass('iterated')
 })
 
+test('opendirSync + encoding', async (t) => {
+  const dir = await withDir(t, 'test/fixtures/dir')
+  await withFile(t, 'test/fixtures/dir/føø.txt', 'hello\n')
+
+  const names = (encoding) => [...fs.opendirSync(dir, encoding)].map((entry) => entry.name)
+
+  t.alike(names('utf8'), ['føø.txt'])
+  t.alike(names('buffer'), [Buffer.from('føø.txt')])
+  t.alike(names('hex'), [Buffer.from('føø.txt').toString('hex')])
+})
+
+test('readdir + withStats: true', async (t) => {
+  await withDir(t, 'test/fixtures/dir/sub')
+  await withFile(t, 'test/fixtures/dir/foo.txt', 'hello\n')
+
+  const entries = await fs.promises.readdir('test/fixtures/dir', {
+    withFileTypes: true,
+    withStats: true
+  })
+
+  const file = entries.find((entry) => entry.name === 'foo.txt')
+
+  t.ok(file.isFile())
+  t.is(file.stats.size, 6)
+  t.is(file.stats.ino, fs.lstatSync('test/fixtures/dir/foo.txt').ino)
+
+  const dir = entries.find((entry) => entry.name === 'sub')
+
+  t.ok(dir.isDirectory())
+  t.ok(dir.stats.isDirectory())
+})
+
+test('readdirSync + withStats: true', async (t) => {
+  await withDir(t, 'test/fixtures/dir')
+  await withFile(t, 'test/fixtures/dir/foo.txt', 'hello\n')
+
+  const [entry] = fs.readdirSync('test/fixtures/dir', { withFileTypes: true, withStats: true })
+
+  t.is(entry.name, 'foo.txt')
+  t.is(entry.stats.size, 6)
+  t.alike(entry.stats.mtime, fs.lstatSync('test/fixtures/dir/foo.txt').mtime)
+
+  t.is(fs.readdirSync('test/fixtures/dir', { withFileTypes: true })[0].stats, null)
+})
+
+test('glob', async (t) => {
+  const cwd = await withDir(t, 'test/fixtures/glob')
+
+  await withDir(t, 'test/fixtures/glob/src/d')
+  await withDir(t, 'test/fixtures/glob/node_modules')
+
+  const files = ['a.js', 'b.ts', '.hidden.js', 'src/c.js', 'src/d/e.js', 'node_modules/f.js']
+
+  for (const file of files) await withFile(t, path.join(cwd, file))
+
+  const glob = async (patterns, opts) => {
+    const result = []
+    for await (const file of fs.glob(patterns, { cwd, ...opts })) result.push(file)
+    return result.sort()
+  }
+
+  t.alike(await glob('**/*.js', { ignore: 'node_modules' }), [
+    'a.js',
+    path.join('src', 'c.js'),
+    path.join('src', 'd', 'e.js')
+  ])
+
+  t.alike(await glob('*.{js,ts}'), ['a.js', 'b.ts'])
+  t.alike(await glob('*.js', { dot: true }), ['.hidden.js', 'a.js'])
+  t.alike(await glob(['src/*', '[ab].*'], { onlyFiles: false }), [
+    'a.js',
+    'b.ts',
+    path.join('src', 'c.js'),
+    path.join('src', 'd')
+  ])
+  t.alike(await glob('missing/**'), [])
+})
+
+test('globSync', async (t) => {
+  const cwd = await withDir(t, 'test/fixtures/glob')
+
+  await withDir(t, 'test/fixtures/glob/src/d')
+
+  for (const file of ['a.js', 'src/c.js', 'src/d/e.js']) {
+    await withFile(t, path.join(cwd, file))
+  }
+
+  t.alike([...fs.globSync('**', { cwd, ignore: ['src/d/**'] })].sort(), [
+    'a.js',
+    path.join('src', 'c.js')
+  ])
+})
+
+test('readFile + direct', async (t) => {
+  const expected = crypto.randomBytes(1024 * 64 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', expected)
+
+  t.alike(await fs.readFile(file, { direct: true }), expected)
+  t.alike(fs.readFileSync(file, { direct: true }), expected)
+})
+
 test('readFile, file missing', async (t) => {
   t.plan(1)
 
@@ -1080,6 +1563,31 @@ test('writeFile + readFile', async (t) => {
   })
 })
 
+test('writeFile + readFile, utf8 strings', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', false)
+
+  const data = 'føø bår ✓ '.repeat(100000)
+
+  await fs.promises.writeFile(file, data)
+
+  t.is(await fs.promises.readFile(file, 'utf8'), data)
+  t.is(fs.readFileSync(file, 'utf8'), data)
+  t.is(fs.readFileSync(file).byteLength, Buffer.byteLength(data))
+
+  fs.writeFileSync(file, 'føø', 'utf-8')
+
+  t.is(fs.readFileSync(file, { encoding: 'utf-8' }), 'føø')
+
+  const fd = fs.openSync(file, 'r+')
+
+  t.is(fs.writeSync(fd, 'bår', 3), 4)
+  t.is(await fs.write(fd, '✓', 7, 'utf8'), 3)
+
+  fs.closeSync(fd)
+
+  t.is(fs.readFileSync(file, 'utf8'), 'føbår✓')
+})
+
 test('appendFile + readFile', async (t) => {
   t.plan(4)
 
@@ -1263,23 +1771,163 @@ test('copyFileSync with COPYFILE_EXCL', async (t) => {
   )
 })
 
-test('cp', async (t) => {
-  t.plan(11)
+test('copyFile + sparse', async (t) => {
+  const src = await withFile(t, 'test/fixtures/foo.txt', false)
+  const dst = await withFile(t, 'test/fixtures/bar.txt', false)
 
-  await withDir(t, 'test/fixtures/dir/foo/bar/baz')
-  await withFile(t, 'test/fixtures/dir/foo/bar/baz/foo.txt', 'foo\n')
+  const fd = fs.openSync(src, 'w+')
+  fs.writeSync(fd, 'hello', 1024 * 1024)
+  fs.ftruncateSync(fd, 4 * 1024 * 1024)
+  fs.closeSync(fd)
 
-  await withDir(t, 'test/fixtures/dir2', false)
+  await fs.copyFile(src, dst, { sparse: true })
 
-  fs.cp('test/fixtures/dir', 'test/fixtures/dir2', { recursive: true }, (err) => {
-    t.absent(err, 'directory copied')
+  t.alike(fs.readFileSync(dst), fs.readFileSync(src))
 
-    fs.open('test/fixtures/dir/foo/bar/baz/foo.txt', (err, fd) => {
-      t.absent(err, 'original copy opened')
+  t.exception(
+    () => fs.copyFileSync(src, dst, { mode: fs.constants.COPYFILE_EXCL, sparse: true }),
+    /file already exists/
+  )
+})
 
-      const data = Buffer.alloc(4)
+test('copyFile + sparse, same file', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'hello world')
 
-      fs.read(fd, data, 0, 4, 0, (err, len) => {
+  await fs.copyFile(file, file, { sparse: true })
+  fs.copyFileSync(file, file, { sparse: true })
+
+  t.alike(fs.readFileSync(file), Buffer.from('hello world'))
+})
+
+test('copyFile + sparse, existing destination', { skip: isWindows }, async (t) => {
+  const src = await withFile(t, 'test/fixtures/foo.txt', 'hello world')
+  const dst = await withFile(t, 'test/fixtures/bar.txt', 'a much longer existing file')
+
+  fs.chmodSync(src, 0o600)
+  fs.chmodSync(dst, 0o644)
+
+  await fs.copyFile(src, dst, { sparse: true })
+
+  t.alike(fs.readFileSync(dst), Buffer.from('hello world'))
+  t.is(fs.statSync(dst).mode & 0o777, 0o600)
+})
+
+test('dataRanges', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', false)
+
+  const fd = fs.openSync(file, 'w+')
+
+  t.teardown(() => fs.closeSync(fd))
+
+  fs.writeSync(fd, 'hello', 1024 * 1024)
+  fs.ftruncateSync(fd, 4 * 1024 * 1024)
+
+  const ranges = []
+
+  for await (const range of fs.dataRanges(fd)) ranges.push(range)
+
+  const data = ranges.find(({ offset, length }) => offset + length > 1024 * 1024)
+
+  t.ok(data, 'has data range')
+  t.ok(data.offset <= 1024 * 1024 && data.offset + data.length >= 1024 * 1024 + 5)
+  t.ok(ranges.every(({ offset, length }) => offset + length <= 4 * 1024 * 1024))
+
+  t.alike([...fs.dataRangesSync(fd)], ranges)
+})
+
+test('du', async (t) => {
+  const dir = await withDir(t, 'test/fixtures/du')
+
+  await withDir(t, 'test/fixtures/du/sub')
+  await withFile(t, 'test/fixtures/du/a', Buffer.alloc(1000))
+  await withFile(t, 'test/fixtures/du/sub/b', Buffer.alloc(500))
+
+  fs.linkSync('test/fixtures/du/a', 'test/fixtures/du/sub/c')
+
+  const size = (...parts) => fs.lstatSync(path.join(dir, ...parts)).size
+  const bytes = size() + size('a') + size('sub') + size('sub', 'b')
+
+  const usage = await fs.du(dir, { apparent: true, children: true })
+
+  t.is(usage.bytes, bytes)
+  t.is(usage.inodes, 4, 'hard link counted once')
+  t.alike(usage.children.map((child) => child.name).sort(), ['a', 'sub'])
+  t.is(usage.children[0].bytes + usage.children[1].bytes, bytes - size())
+
+  const all = fs.duSync(dir, { apparent: true, countHardlinksOnce: false })
+
+  t.is(all.bytes, bytes + 1000)
+  t.is(all.inodes, 5)
+
+  t.is((await fs.du(dir, { maxDepth: 1, apparent: true })).inodes, 3)
+})
+
+test('du, deep tree', async (t) => {
+  const dir = await withDir(t, 'test/fixtures/du-deep')
+
+  let parent = dir
+
+  for (let i = 0; i < 200; i++) {
+    parent = path.join(parent, 'd')
+
+    fs.mkdirSync(parent)
+    fs.writeFileSync(path.join(parent, 'f'), Buffer.alloc(i))
+  }
+
+  const usage = await fs.du(dir, { apparent: true, children: true, concurrency: 2 })
+  const expected = fs.duSync(dir, { apparent: true })
+
+  t.is(usage.inodes, 401)
+  t.is(usage.bytes, expected.bytes)
+  t.is(usage.children[0].bytes, expected.bytes - fs.lstatSync(dir).size)
+
+  t.is((await fs.du(dir, { maxDepth: 3, apparent: true })).inodes, 6)
+})
+
+test('snapshot + diff', async (t) => {
+  const root = await withDir(t, 'test/fixtures/snapshot')
+
+  await withDir(t, 'test/fixtures/snapshot/b')
+  await withFile(t, 'test/fixtures/snapshot/a', 'hello')
+  await withFile(t, 'test/fixtures/snapshot/b/c', 'world')
+
+  const a = await fs.snapshot(root, { contents: true })
+
+  t.alike(fs.diff(a, a), [])
+  t.alike(fs.diff(a, fs.snapshotSync(root, { contents: true })), [])
+
+  fs.writeFileSync('test/fixtures/snapshot/b/c', 'there')
+  fs.rmSync('test/fixtures/snapshot/a')
+  fs.mkdirSync('test/fixtures/snapshot/d')
+
+  const b = await fs.snapshot(root, { contents: true })
+
+  t.alike(fs.diff(a, b), [
+    { type: 'remove', path: 'a' },
+    { type: 'change', path: path.join('b', 'c') },
+    { type: 'add', path: 'd' }
+  ])
+
+  t.exception(() => fs.diff(a, fs.snapshotSync(root)), /different options/)
+})
+
+test('cp', async (t) => {
+  t.plan(11)
+
+  await withDir(t, 'test/fixtures/dir/foo/bar/baz')
+  await withFile(t, 'test/fixtures/dir/foo/bar/baz/foo.txt', 'foo\n')
+
+  await withDir(t, 'test/fixtures/dir2', false)
+
+  fs.cp('test/fixtures/dir', 'test/fixtures/dir2', { recursive: true }, (err) => {
+    t.absent(err, 'directory copied')
+
+    fs.open('test/fixtures/dir/foo/bar/baz/foo.txt', (err, fd) => {
+      t.absent(err, 'original copy opened')
+
+      const data = Buffer.alloc(4)
+
+      fs.read(fd, data, 0, 4, 0, (err, len) => {
         t.absent(err, 'read original copy')
         t.is(len, 4)
         t.alike(data, Buffer.from('foo\n'), 'check original copy content')
@@ -1405,6 +2053,68 @@ test('realpath sync', async (t) => {
   t.is(fs.realpathSync(link), path.resolve('test/fixtures/foo'))
 })
 
+test('realpath + cache', async (t) => {
+  await withDir(t, 'test/fixtures/foo')
+  await withFile(t, 'test/fixtures/foo/bar.txt')
+  await withFile(t, 'test/fixtures/foo/baz.txt')
+  await withSymlink(t, 'test/fixtures/foo-link', 'foo')
+
+  const cache = new fs.RealpathCache()
+
+  t.is(
+    await fs.promises.realpath('test/fixtures/foo-link/bar.txt', { cache }),
+    path.resolve('test/fixtures/foo/bar.txt')
+  )
+
+  let misses = cache.misses
+
+  t.is(
+    await fs.promises.realpath('test/fixtures/foo-link/baz.txt', { cache }),
+    path.resolve('test/fixtures/foo/baz.txt')
+  )
+
+  t.is(cache.misses, misses + 1, 'only the file resolved')
+
+  t.is(
+    fs.realpathSync('test/fixtures/foo-link/baz.txt', { cache }),
+    path.resolve('test/fixtures/foo/baz.txt')
+  )
+
+  t.is(cache.misses, misses + 1, 'file served from cache')
+
+  misses = cache.misses
+
+  cache.invalidate(path.resolve('test/fixtures/foo'))
+
+  t.is(
+    fs.realpathSync('test/fixtures/foo-link/baz.txt', { cache }),
+    path.resolve('test/fixtures/foo/baz.txt')
+  )
+
+  t.ok(cache.misses > misses, 'entries resolving below the invalidated path dropped')
+})
+
+test('realpath + cache, symlink loop', { skip: isWindows }, async (t) => {
+  await withSymlink(t, 'test/fixtures/foo-link', 'bar-link')
+  await withSymlink(t, 'test/fixtures/bar-link', 'foo-link')
+
+  const cache = new fs.RealpathCache()
+
+  await t.exception(fs.promises.realpath('test/fixtures/foo-link/baz.txt', { cache }), /ELOOP/)
+
+  t.exception(() => fs.realpathSync('test/fixtures/foo-link', { cache }), /ELOOP/)
+})
+
+test('realpath + cache, file missing', async (t) => {
+  const cache = new fs.RealpathCache()
+
+  await t.exception(fs.promises.realpath('test/fixtures/foo.txt', { cache }), /ENOENT/)
+
+  t.exception(() => fs.realpathSync('test/fixtures/foo.txt', { cache }), /ENOENT/)
+
+  t.is(cache.hits, 1, 'missing file cached')
+})
+
 test('readlink', async (t) => {
   t.plan(2)
 
@@ -1479,6 +2189,81 @@ test('createReadStream, large file', async (t) => {
     .on('end', () => t.alike(Buffer.concat(read), expected))
 })
 
+test('createReadStream + pool', async (t) => {
+  t.plan(2)
+
+  const expected = crypto.randomBytes(1024 * 512 /* 512 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo', expected)
+
+  const pool = new fs.BufferPool({ slabSize: 64 * 1024, maxFreeSlabs: 1 })
+
+  const stream = fs.createReadStream(file, { pool })
+  const read = []
+
+  stream
+    .on('data', (data) => {
+      read.push(Buffer.from(data))
+      pool.release(data)
+    })
+    .on('end', () => {
+      t.alike(Buffer.concat(read), expected)
+      t.ok(pool.size < expected.byteLength / pool.slabSize, 'slabs are reused')
+    })
+})
+
+test('createReadStream + pool, destroyed mid-read', async (t) => {
+  t.plan(3)
+
+  const expected = crypto.randomBytes(1024 * 512 /* 512 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo', expected)
+
+  const pool = new fs.BufferPool({ slabSize: 64 * 1024, maxFreeSlabs: 1 })
+
+  const stream = fs.createReadStream(file, { pool })
+
+  let first = null
+
+  stream
+    .once('data', (data) => {
+      first = data
+
+      // Buffered and in-flight chunks are never released.
+      stream.destroy()
+    })
+    .on('close', () => {
+      t.alike(first, expected.subarray(0, first.byteLength))
+
+      // Releasing late is still fine.
+      pool.release(first)
+
+      const buffer = pool.alloc(1024)
+      t.is(buffer.byteLength, 1024)
+      pool.release(buffer)
+
+      t.ok(pool.size <= expected.byteLength / pool.slabSize, 'no more slabs than data read')
+    })
+})
+
+test('createReadStream + sparse', async (t) => {
+  t.plan(1)
+
+  const file = await withFile(t, 'test/fixtures/foo', false)
+
+  const fd = fs.openSync(file, 'w+')
+  fs.writeSync(fd, 'hello', 256 * 1024)
+  fs.ftruncateSync(fd, 1024 * 1024)
+  fs.closeSync(fd)
+
+  const stream = fs.createReadStream(file, { sparse: true })
+  const read = []
+
+  stream
+    .on('data', (data) => read.push(data))
+    .on('end', () => t.alike(Buffer.concat(read), fs.readFileSync(file)))
+})
+
 test('createWriteStream', async (t) => {
   t.plan(2)
 
@@ -1497,6 +2282,128 @@ test('createWriteStream', async (t) => {
   stream.end(' world')
 })
 
+test('createWriteStream + start, concurrent regions', async (t) => {
+  t.plan(2)
+
+  const expected = crypto.randomBytes(1024 * 256 /* 256 KiB */)
+
+  const file = await withFile(t, 'test/fixtures/foo', Buffer.alloc(expected.byteLength))
+
+  const half = expected.byteLength / 2
+
+  await Promise.all(
+    [0, half].map((start) => {
+      const stream = fs.createWriteStream(file, { flags: 'r+', start, concurrency: 4 })
+
+      for (let i = start; i < start + half; i += 4096) {
+        stream.write(expected.subarray(i, i + 4096))
+      }
+
+      stream.end()
+
+      return new Promise((resolve) => stream.on('close', resolve))
+    })
+  )
+
+  const data = await fs.promises.readFile(file)
+
+  t.is(data.byteLength, expected.byteLength)
+  t.alike(data, expected)
+})
+
+test('createWriteStream + preallocate', async (t) => {
+  t.plan(4)
+
+  const file = await withFile(t, 'test/fixtures/foo')
+
+  const stream = fs.createWriteStream(file, { preallocate: 64 * 1024 })
+
+  stream.on('close', () =>
+    fs.readFile(file, (err, data) => {
+      t.absent(err)
+      t.alike(data, Buffer.from('hello world'))
+      const st = fs.statSync(file)
+      t.is(st.size, 11)
+      t.ok(st.blocks * 512 < 64 * 1024, 'releases the space reserved past the end')
+    })
+  )
+
+  stream.write('hello')
+  stream.end(' world')
+})
+
+test('createWriteStream + writeback', async (t) => {
+  t.plan(2)
+
+  const expected = crypto.randomBytes(1024 * 256 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo')
+
+  const stream = fs.createWriteStream(file, { writeback: { window: 64 * 1024, dropCache: true } })
+
+  stream.on('close', () =>
+    fs.readFile(file, (err, data) => {
+      t.absent(err)
+      t.alike(data, expected)
+    })
+  )
+
+  for (let i = 0; i < expected.byteLength; i += 10000) {
+    stream.write(expected.subarray(i, i + 10000))
+  }
+
+  stream.end()
+})
+
+test('writeFile + writeback', async (t) => {
+  const expected = crypto.randomBytes(1024 * 256 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo')
+
+  await fs.promises.writeFile(file, expected, { writeback: { window: 64 * 1024 } })
+
+  t.alike(await fs.promises.readFile(file), expected)
+
+  fs.writeFileSync(file, expected, { flag: 'a', writeback: { window: 64 * 1024, dropCache: true } })
+
+  t.alike(fs.readFileSync(file), Buffer.concat([expected, expected]))
+})
+
+test('createReadStream + direct', async (t) => {
+  t.plan(1)
+
+  const expected = crypto.randomBytes(1024 * 512 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo', expected)
+
+  const stream = fs.createReadStream(file, { direct: true, start: 100 })
+  const read = []
+
+  stream
+    .on('data', (data) => read.push(data))
+    .on('end', () => t.alike(Buffer.concat(read), expected.subarray(100)))
+})
+
+test('createWriteStream + direct', async (t) => {
+  t.plan(2)
+
+  const expected = crypto.randomBytes(1024 * 1024 * 2 + 123)
+
+  const file = await withFile(t, 'test/fixtures/foo')
+
+  const stream = fs.createWriteStream(file, { direct: true })
+
+  stream.on('close', () =>
+    fs.readFile(file, (err, data) => {
+      t.absent(err)
+      t.alike(data, expected)
+    })
+  )
+
+  stream.write(expected.subarray(0, 1000))
+  stream.end(expected.subarray(1000))
+})
+
 test('sync methods', async (t) => {
   t.plan(4)
 
@@ -1515,6 +2422,181 @@ test('sync methods', async (t) => {
   })
 })
 
+test('LogWriter', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'head\n')
+  const fd = fs.openSync(file, 'r+')
+
+  t.teardown(() => fs.closeSync(fd))
+
+  const log = new fs.LogWriter(fd)
+
+  const positions = await Promise.all([
+    log.append('foo\n'),
+    log.append('bar\n'),
+    log.append('baz\n')
+  ])
+
+  t.alike(positions, [5, 9, 13])
+  t.is(log.position, 17)
+  t.alike(fs.readFileSync(file), Buffer.from('head\nfoo\nbar\nbaz\n'))
+
+  await log.close()
+
+  await t.exception(log.append('qux\n'), /closed/)
+})
+
+test('LogWriter, commit delay and batch size', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', false)
+  const fd = fs.openSync(file, 'w+')
+
+  t.teardown(() => fs.closeSync(fd))
+
+  const log = new fs.LogWriter(fd, { position: 0, commitDelay: 1000, maxBatchSize: 8 })
+
+  const pending = [log.append('aaaa'), log.append('bbbb'), log.append('c')]
+
+  await log.flush()
+
+  t.alike(await Promise.all(pending), [0, 4, 8])
+  t.alike(fs.readFileSync(file), Buffer.from('aaaabbbbc'))
+})
+
+test('LogWriter, sequential appends', async (t) => {
+  const file = await withFile(t, 'test/fixtures/foo.txt', false)
+  const fd = fs.openSync(file, 'w+')
+
+  t.teardown(() => fs.closeSync(fd))
+
+  const log = new fs.LogWriter(fd, { position: 0 })
+
+  t.is(await log.append('foo\n'), 0)
+  t.is(await log.append('bar\n'), 4)
+
+  const delayed = new fs.LogWriter(fd, { position: 8, commitDelay: 10 })
+
+  t.is(await delayed.append('baz\n'), 8)
+  t.is(await delayed.append('qux\n'), 12)
+
+  t.alike(fs.readFileSync(file), Buffer.from('foo\nbar\nbaz\nqux\n'))
+})
+
+test('TreeIndex', async (t) => {
+  await withDir(t, 'test/fixtures/tree')
+
+  const root = await withDir(t, 'test/fixtures/tree/a/b')
+
+  await withFile(t, 'test/fixtures/tree/a/foo.txt', 'hello')
+  await withFile(t, 'test/fixtures/tree.index')
+
+  const index = new fs.TreeIndex('test/fixtures/tree', 'test/fixtures/tree.index')
+
+  t.is(await index.load(), false, 'empty index file ignored')
+  t.is((await index.scan()).length, 3)
+
+  await index.save()
+
+  const restored = new fs.TreeIndex('test/fixtures/tree', 'test/fixtures/tree.index')
+
+  t.is(await restored.load(), true)
+  t.is(restored.size, 3)
+  t.alike(restored.entries('test/fixtures/tree/a').map((entry) => entry.name).sort(), [
+    'b',
+    'foo.txt'
+  ])
+
+  fs.rmdirSync(root)
+
+  t.ok((await restored.scan()).includes(path.resolve('test/fixtures/tree', 'a')))
+  t.is(restored.entries(root), null)
+  t.alike(restored.entries('test/fixtures/tree/a').map((entry) => entry.name), ['foo.txt'])
+})
+
+test('TreeIndex, relative root + watch', async (t) => {
+  await withDir(t, 'test/fixtures/tree')
+  await withDir(t, 'test/fixtures/tree/a')
+
+  const index = new fs.TreeIndex('./test/fixtures/tree/', 'test/fixtures/tree.index')
+
+  t.teardown(() => index.close())
+
+  await index.scan()
+
+  t.is(index.size, 2)
+  t.is(index.root, path.resolve('test/fixtures/tree'))
+
+  fs.rmdirSync('test/fixtures/tree/a')
+
+  await index.scan()
+
+  t.is(index.size, 1, 'removed directory pruned')
+  t.is(index.entries('./test/fixtures/tree/a'), null)
+
+  index.watch()
+
+  fs.mkdirSync('test/fixtures/tree/c/d', { recursive: true })
+
+  const until = async (fn) => {
+    for (let i = 0; i < 100 && !fn(); i++) await new Promise((resolve) => setTimeout(resolve, 20))
+  }
+
+  await until(() => index.entries('test/fixtures/tree/c/d') !== null)
+
+  t.alike(index.entries('test/fixtures/tree/c').map((entry) => entry.name), ['d'])
+  t.alike(index.entries('test/fixtures/tree/c/d'), [], 'new directory walked')
+
+  fs.rmSync('test/fixtures/tree/c', { recursive: true })
+
+  await until(() => index.entries('test/fixtures/tree/c') === null)
+
+  t.is(index.size, 1, 'removed subtree pruned')
+})
+
+test('StatWatcher', async (t) => {
+  const a = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
+  const b = await withFile(t, 'test/fixtures/bar.txt', false)
+
+  const watcher = new fs.StatWatcher([a, b], { interval: 10, jitter: 5 })
+
+  t.teardown(() => watcher.close())
+
+  t.is(watcher.size, 2)
+
+  await new Promise((resolve) => setTimeout(resolve, 50))
+
+  fs.appendFileSync(a, 'hello world\n')
+  fs.appendFileSync(b, 'bar\n')
+
+  const changes = []
+
+  while (new Set(changes.map((change) => change.filename)).size < 2) {
+    changes.push(...(await new Promise((resolve) => watcher.once('change', resolve))))
+  }
+
+  const change = changes.find((change) => change.filename === a)
+
+  t.is(change.prev.size, 4)
+  t.is(change.curr.size, 16)
+
+  t.is(changes.find((change) => change.filename === b).prev.ino, 0, 'created')
+})
+
+test('watchFile + unwatchFile', async (t) => {
+  t.plan(2)
+
+  const file = await withFile(t, 'test/fixtures/foo.txt', 'foo\n')
+
+  fs.watchFile(file, { interval: 10 }, (curr, prev) => {
+    t.is(prev.size, 4)
+    t.is(curr.size, 16)
+
+    fs.unwatchFile(file)
+  })
+
+  await new Promise((resolve) => setTimeout(resolve, 50))
+
+  fs.appendFileSync(file, 'hello world\n')
+})
+
 test('teardown with read enqueued from exit listener', (t) => {
   t.plan(1)
 